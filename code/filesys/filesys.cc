@@ -30,7 +30,9 @@
 //
 // 	Our implementation at this point has the following restrictions:
 //
-//	   there is no synchronization for concurrent accesses
+//	   operations on the directories are serialized by a reader-writer
+//	     lock: lookups run concurrently, changes one at a time; there
+//	     is no synchronization for concurrent accesses to open files
 //	   files have a fixed size, set when the file is created
 //	   files cannot be bigger than about 3KB in size
 //	   there is no hierarchical directory structure, and only a limited
@@ -50,6 +52,7 @@
 #include "directory.h"
 #include "filehdr.h"
 #include "filesys.h"
+#include "synch.h"
 
 // Sectors containing the file headers for the bitmap of free sectors,
 // and the directory of files.  These file headers are placed in well-known 
@@ -141,6 +144,7 @@ FileSystem::FileSystem(bool format)
         freeMapFile = new OpenFile(FreeMapSector);
         directoryFile = new OpenFile(DirectorySector);
     }
+     directoryLock = new RWLock("directory lock", FifoFairness);
      cd = DirectorySector;
      parentCd = DirectorySector;
      for(int i = 0; i < 10; i++){
@@ -170,8 +174,8 @@ FileSystem::FileSystem(bool format)
 //	 	no free entry for file in directory
 //	 	no free space for data blocks for the file 
 //
-// 	Note that this implementation assumes there is no concurrent access
-//	to the file system!
+// 	The directory lock is held for writing, so that two threads
+//	cannot take the same free sector or directory entry.
 //
 //	"name" -- name of file to be created
 //	"initialSize" -- size of file to be created
@@ -189,6 +193,7 @@ FileSystem::Create(const char *name, int initialSize, int type)
     bool success;
     DEBUG('f', "Creating file %s, size %d\n", name, initialSize);
 
+    directoryLock->AcquireWrite();
     directory = new Directory(NumDirEntries, cd, parentCd);
     directory->FetchFrom(cdLoaded);
     directory->setup();
@@ -227,6 +232,7 @@ FileSystem::Create(const char *name, int initialSize, int type)
 	}
         delete freeMap;
     }
+    directoryLock->ReleaseWrite();
     delete directory;
     delete cdLoaded;
     return success;
@@ -249,10 +255,12 @@ FileSystem::Open(const char *name)
     int sector;
 
     DEBUG('f', "Opening file %s\n", name);
+    directoryLock->AcquireRead();
     directory->FetchFrom(directoryFile);
     sector = directory->Find(name); 
     if (sector >= 0) 		
 	openFile = new OpenFile(sector);	// name was found in directory 
+    directoryLock->ReleaseRead();
     delete directory;
     return openFile;				// return NULL if not found
 }
@@ -274,6 +282,26 @@ FileSystem::Open(const char *name)
 
 bool
 FileSystem::Remove(const char *name)
+{
+    bool success;
+
+    directoryLock->AcquireWrite();
+    success = RemoveLocked(name);
+    directoryLock->ReleaseWrite();
+    return success;
+}
+
+//----------------------------------------------------------------------
+// FileSystem::RemoveLocked
+// 	Delete a file from the file system, as Remove does, with the
+//	directory lock already held for writing -- a directory is
+//	removed by removing its files first.
+//
+//	"name" -- the text name of the file to be removed
+//----------------------------------------------------------------------
+
+bool
+FileSystem::RemoveLocked(const char *name)
 { 
     if(name == NULL){return FALSE;}
     Directory *directory;
@@ -298,7 +326,7 @@ FileSystem::Remove(const char *name)
         int tmp = cd;
         for(int i = 2; i < NumDirEntries; i++){
             cd = sector;
-            this->Remove(directory->getFileName(i));
+            RemoveLocked(directory->getFileName(i));
             cd = tmp;
         }
     }
@@ -327,12 +355,14 @@ FileSystem::Remove(const char *name)
 void
 FileSystem::List()
 {
+    directoryLock->AcquireRead();
     Directory *directory = new Directory(NumDirEntries, cd, parentCd);
     OpenFile *openFile = new OpenFile(cd);
 
     directory->FetchFrom(openFile);
     directory->setup();
     directory->List();
+    directoryLock->ReleaseRead();
     delete directory;
     delete openFile;
 }
@@ -356,6 +386,7 @@ FileSystem::Print()
     Directory *directory = new Directory(NumDirEntries, cd,parentCd);
     OpenFile *openFile = new OpenFile(cd);
 
+    directoryLock->AcquireRead();
     printf("Bit map file header:\n");
     bitHdr->FetchFrom(FreeMapSector);
     bitHdr->Print();
@@ -370,6 +401,7 @@ FileSystem::Print()
     directory->FetchFrom(openFile);
     directory->setup();
     directory->Print();
+    directoryLock->ReleaseRead();
 
     delete bitHdr;
     delete dirHdr;
@@ -387,6 +419,7 @@ FileSystem::Print()
 //----------------------------------------------------------------------
 
 int FileSystem::moveCd(char *name){
+    directoryLock->AcquireWrite();
     Directory *directory = new Directory(NumDirEntries, cd, parentCd);
     OpenFile *openFile = new OpenFile(cd);
     int newSector;
@@ -395,6 +428,7 @@ int FileSystem::moveCd(char *name){
     directory->setup();
     if((newSector = directory->Find(name)) == -1){
         printf("error: unable to find %s in the current directory\n", name);
+        directoryLock->ReleaseWrite();
         delete directory;
         return -1;
     }
@@ -402,6 +436,7 @@ int FileSystem::moveCd(char *name){
     FileHeader *h = new FileHeader();
     h->FetchFrom(newSector);
     if(h->getType()==1){
+        directoryLock->ReleaseWrite();
         delete h;
         printf("%s is not a directory\n", name);
         return -1;
@@ -421,6 +456,7 @@ int FileSystem::moveCd(char *name){
         parentCd = cd;
         cd = newSector;
     }
+    directoryLock->ReleaseWrite();
     return 1;
 }
 
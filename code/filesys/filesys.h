@@ -39,6 +39,8 @@
 #include "openfile.h"
 #include "directory.h"
 
+class RWLock; // see synch.h
+
 #ifdef FILESYS_STUB 		// Temporarily implement file system calls as 
 				// calls to UNIX, until the real file system
 				// implementation is available
@@ -98,8 +100,14 @@ class FileSystem {
 	void do_userClose(int fd){delete userFile[fd]; userFile[fd] = NULL;}
 
   private:
+	bool RemoveLocked(const char *name); // Remove, with directoryLock
+					// held for writing
+
 	OpenFile *userFile[10];
 
+   RWLock *directoryLock;		// Lookups share it; changes to the
+					// directories (and to "cd") take it
+
    OpenFile* freeMapFile;		// Bit map of free disk blocks,
 					// represented as a file
    OpenFile* directoryFile;		// "Root" directory -- list of 
@@ -52,6 +52,11 @@ class OpenFile {
 		}
 
     int Length() { Lseek(file, 0, 2); return Tell(file); }
+
+    int HeaderSector() { return FileNumber(file); }
+					// There is no file header: the number
+					// of the UNIX file stands for its
+					// sector (cf. the "real" version)
     
   private:
     int file;
@@ -85,10 +90,14 @@ class OpenFile {
 					// file (this interface is simpler 
 					// than the UNIX idiom -- lseek to 
 					// end of file, tell, lseek back 
+    int HeaderSector() { return hdrSector; } // Where the header is: this
+					// tells the file apart from the
+					// others, whatever its name
     FileHeader *getHeader(){return hdr;}
 	void setHeader(FileHeader * h){hdr = h;}
   private:
     FileHeader *hdr;			// Header for this file 
+    int hdrSector;			// ... and where it is on disk
     int seekPosition;			// Current position within the file
 };
 
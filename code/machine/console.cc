@@ -62,6 +62,7 @@ Console::Console(char *readFile, char *writeFile, VoidFunctionPtr readAvail,
     // start polling for incoming packets
     interrupt->Schedule(ConsoleReadPoll, (int)this, ConsoleTime,
                         ConsoleReadInt);
+    interrupt->WatchInput(readFileNo);
 }
 
 //----------------------------------------------------------------------
@@ -70,6 +71,7 @@ Console::Console(char *readFile, char *writeFile, VoidFunctionPtr readAvail,
 //----------------------------------------------------------------------
 
 Console::~Console() {
+    interrupt->IgnoreInput(readFileNo);
     if (readFileNo != 0)
         Close(readFileNo);
     if (writeFileNo != 1)
@@ -23,6 +23,9 @@
 #include "interrupt.h"
 #include "copyright.h"
 #include "system.h"
+#ifdef USER_PROGRAM
+#include "profile.h"
+#endif
 
 // String definitions for debugging messages
 
@@ -32,6 +35,9 @@ static const char *intTypeNames[] = {"timer",         "disk",
                                      "console write", "console read",
                                      "network send",  "network recv"};
 
+static ObjectPool pendingInterruptPool("pending interrupt",
+                                       sizeof(PendingInterrupt));
+
 //----------------------------------------------------------------------
 // PendingInterrupt::PendingInterrupt
 //      Initialize a hardware device interrupt that is to be scheduled
@@ -51,6 +57,200 @@ PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, int param,
     type = kind;
 }
 
+//----------------------------------------------------------------------
+// PendingInterrupt::operator new, PendingInterrupt::operator delete
+//      Every device interrupt allocates a PendingInterrupt, and frees it
+//      once it fired: recycle them through a pool.
+//----------------------------------------------------------------------
+
+void *PendingInterrupt::operator new(size_t size) {
+    return pendingInterruptPool.Allocate(size);
+}
+
+void PendingInterrupt::operator delete(void *p) {
+    pendingInterruptPool.Free(p);
+}
+
+//----------------------------------------------------------------------
+// Before
+//      Return TRUE if "a" has to fire before "b": it is due earlier, or
+//      at the same time but was scheduled first.
+//----------------------------------------------------------------------
+
+static bool Before(PendingInterrupt *a, PendingInterrupt *b) {
+    if (a->when != b->when)
+        return a->when < b->when;
+    return (int)(a->order - b->order) < 0; // correct across wrap-around
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::PendingQueue
+//      Initialize an empty queue of pending interrupts.
+//----------------------------------------------------------------------
+
+PendingQueue::PendingQueue() {
+    size = 16;
+    heap = new PendingInterrupt *[size];
+    count = 0;
+    nextOrder = 0;
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::~PendingQueue
+//      De-allocate the queue.  The caller is responsible for the
+//      interrupts still on it.
+//----------------------------------------------------------------------
+
+PendingQueue::~PendingQueue() { delete[] heap; }
+
+//----------------------------------------------------------------------
+// PendingQueue::Insert
+//      Put an interrupt on the queue, behind any interrupt already
+//      queued for the same time: sift it up from the bottom of the heap.
+//
+//      "toOccur" -- the interrupt to schedule
+//----------------------------------------------------------------------
+
+void PendingQueue::Insert(PendingInterrupt *toOccur) {
+    int i, parent;
+
+    if (count == size) { // full: double the heap
+        PendingInterrupt **bigger = new PendingInterrupt *[2 * size];
+        for (i = 0; i < count; i++)
+            bigger[i] = heap[i];
+        delete[] heap;
+        heap = bigger;
+        size *= 2;
+    }
+
+    toOccur->order = nextOrder++;
+    for (i = count++; i > 0; i = parent) {
+        parent = (i - 1) / 2;
+        if (!Before(toOccur, heap[parent]))
+            break;
+        heap[i] = heap[parent];
+    }
+    heap[i] = toOccur;
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::RemoveFirst
+//      Take the earliest interrupt off the queue: move the last one to
+//      the top of the heap, and sift it down.
+//
+// Returns:
+//      The interrupt, or NULL if the queue is empty.
+//----------------------------------------------------------------------
+
+PendingInterrupt *PendingQueue::RemoveFirst() {
+    PendingInterrupt *first, *last;
+    int i, child;
+
+    if (count == 0)
+        return NULL;
+    first = heap[0];
+    last = heap[--count];
+    for (i = 0; (child = 2 * i + 1) < count; i = child) {
+        if ((child + 1 < count) && Before(heap[child + 1], heap[child]))
+            child++;
+        if (!Before(heap[child], last))
+            break;
+        heap[i] = heap[child];
+    }
+    heap[i] = last;
+    return first;
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::Rebuild
+//      Put the heap back in order after the deadlines of interrupts on
+//      it were changed in place: sift down every parent, bottom-up.
+//----------------------------------------------------------------------
+
+void PendingQueue::Rebuild() {
+    PendingInterrupt *top;
+    int i, j, child;
+
+    for (i = count / 2 - 1; i >= 0; i--) {
+        top = heap[i];
+        for (j = i; (child = 2 * j + 1) < count; j = child) {
+            if ((child + 1 < count) && Before(heap[child + 1], heap[child]))
+                child++;
+            if (!Before(heap[child], top))
+                break;
+            heap[j] = heap[child];
+        }
+        heap[j] = top;
+    }
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::Rotate
+//      Move the earliest interrupt behind all the others due at the same
+//      time, as many times as asked: each time, it is taken off the
+//      heap and inserted again, which gives it the last "order".
+//
+//      "times" -- how many times to move the earliest interrupt
+//----------------------------------------------------------------------
+
+void PendingQueue::Rotate(long long times) {
+    int group;
+
+    if (count < 2)
+        return;
+    group = CountDue(0, heap[0]->when);
+    for (times %= group; times > 0; times--)
+        Insert(RemoveFirst());
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::CountDue
+//      Count the interrupts due at "when" in the subtree of heap[i],
+//      "when" being the earliest deadline: the subtree of an interrupt
+//      due later holds none.
+//----------------------------------------------------------------------
+
+int PendingQueue::CountDue(int i, long long when) {
+    if ((i >= count) || (heap[i]->when != when))
+        return 0;
+    return 1 + CountDue(2 * i + 1, when) + CountDue(2 * i + 2, when);
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::Mapcar
+//      Apply a function to each interrupt on the queue, in the order
+//      they will fire.  Sorts a copy of the heap (insertion sort), so
+//      it is only meant for debugging output.
+//
+//      "func" is the procedure to apply to each interrupt
+//----------------------------------------------------------------------
+
+void PendingQueue::Mapcar(VoidFunctionPtr func) {
+    PendingInterrupt **sorted = new PendingInterrupt *[size];
+    int i, j;
+
+    for (i = 0; i < count; i++) {
+        for (j = i; (j > 0) && Before(heap[i], sorted[j - 1]); j--)
+            sorted[j] = sorted[j - 1];
+        sorted[j] = heap[i];
+    }
+    for (i = 0; i < count; i++)
+        (*func)((int)sorted[i]);
+    delete[] sorted;
+}
+
+//----------------------------------------------------------------------
+// IsPolling
+//      Return TRUE for the interrupts devices schedule over and over
+//      whether or not anything happens -- the timer, and the polls for
+//      input -- as opposed to the completion of a disk request, etc.
+//----------------------------------------------------------------------
+
+static bool IsPolling(IntType type) {
+    return (type == TimerInt) || (type == ConsoleReadInt) ||
+           (type == NetworkRecvInt);
+}
+
 //----------------------------------------------------------------------
 // Interrupt::Interrupt
 //      Initialize the simulation of hardware device interrupts.
@@ -60,9 +260,14 @@ PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, int param,
 
 Interrupt::Interrupt() {
     level = IntOff;
-    pending = new List();
+    pending = new PendingQueue();
+    nextDue = NeverDue;
+    putBacks = 0;
+    numCompletions = 0;
+    numWatched = 0;
     inHandler = FALSE;
     yieldOnReturn = FALSE;
+    sliceOver = FALSE;
     status = SystemMode;
 }
 
@@ -72,11 +277,10 @@ Interrupt::Interrupt() {
 //----------------------------------------------------------------------
 
 Interrupt::~Interrupt() {
-    while (!pending->IsEmpty())
-        // LB: correction
-        // delete pending->Remove();
-        delete (PendingInterrupt *)(pending->Remove());
-    // End of correction
+    PendingInterrupt *toOccur;
+
+    while ((toOccur = pending->RemoveFirst()) != NULL)
+        delete toOccur;
     delete pending;
 }
 
@@ -141,6 +345,11 @@ void Interrupt::Enable() { (void)SetLevel(IntOn); }
 //      Two things can cause OneTick to be called:
 //              interrupts are re-enabled
 //              a user instruction is executed
+//
+//      Most ticks have nothing to fire: comparing the time with nextDue
+//      is enough to tell, without going through the pending list.
+//      (When tracing interrupts, we take the long way, which prints the
+//      interrupt state at each tick.)
 //----------------------------------------------------------------------
 void Interrupt::OneTick() {
     MachineStatus old = status;
@@ -154,6 +363,10 @@ void Interrupt::OneTick() {
         stats->userTicks += UserTick;
     }
     DEBUG('i', "\n== Tick %d ==\n", stats->totalTicks);
+    if ((stats->totalTicks < nextDue) && !DebugIsEnabled('i')) {
+        putBacks++; // as CheckIfDue would have
+        return;     // nothing can fire yet
+    }
 
     // check any pending interrupts are now ready to fire
     ChangeLevel(IntOn, IntOff); // first, turn off interrupts
@@ -164,27 +377,69 @@ void Interrupt::OneTick() {
     ChangeLevel(IntOff, IntOn); // re-enable interrupts
     if (yieldOnReturn) {        // if the timer device handler asked
         // for a context switch, ok to do it now
+        bool endOfSlice = sliceOver; // or a woken thread comes first
+
         yieldOnReturn = FALSE;
+        sliceOver = FALSE;
         status = SystemMode; // yield is a kernel routine
-        currentThread->Yield();
+        currentThread->Preempt(endOfSlice);
         status = old;
     }
 }
 
+//----------------------------------------------------------------------
+// Interrupt::UpdateNextDue
+//      Recompute nextDue, the time at which the earliest pending interrupt
+//      is due, after the pending list has changed.  Until then, OneTick
+//      has nothing to fire, which also lets the machine simulation
+//      account for a run of user instructions without calling it.
+//----------------------------------------------------------------------
+
+void Interrupt::UpdateNextDue() {
+    PendingInterrupt *first = pending->First();
+
+    nextDue = (first != NULL) ? first->when : NeverDue;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::CatchUpOrder
+//      Put the interrupts due at the same time in the order the sorted
+//      list they used to be kept on would have them in.  Each time the
+//      list was checked before its first interrupt was due, that
+//      interrupt was taken off and put back, behind the others due at
+//      the same time; so these fired in an order that depended on how
+//      many ticks had been checked.
+//
+//      Rather than going through the queue at each tick, OneTick only
+//      counts these checks, in putBacks; the moves are done here, before
+//      anything looks at the order of the queue or changes it.
+//----------------------------------------------------------------------
+
+void Interrupt::CatchUpOrder() {
+    pending->Rotate(putBacks);
+    putBacks = 0;
+}
+
 //----------------------------------------------------------------------
 // Interrupt::YieldOnReturn
 //      Called from within an interrupt handler, to cause a context switch
 //      (for example, on a time slice) in the interrupted thread,
 //      when the handler returns.
 //
+//      "endOfSlice" is TRUE if the interrupted thread used up its time
+//      slice, so that the scheduling policy sees it preempted; FALSE if
+//      it only has to make way for a thread the handler woke up.
+//
 //      We can't do the context switch here, because that would switch
 //      out the interrupt handler, and we want to switch out the
 //      interrupted thread.
 //----------------------------------------------------------------------
 
-void Interrupt::YieldOnReturn() {
+void Interrupt::YieldOnReturn(bool endOfSlice) {
     ASSERT(inHandler == TRUE);
     yieldOnReturn = TRUE;
+    if (endOfSlice)
+        sliceOver = TRUE;
 }
 
 //----------------------------------------------------------------------
@@ -197,15 +452,26 @@ void Interrupt::YieldOnReturn() {
 //
 //      If there are no pending interrupts, stop.  There's nothing
 //      more for us to do.
+//
+//      If all that is pending is polls for input (and timer ticks), no
+//      thread can become ready before some input arrives, so we first
+//      block the host until it does, on the files the devices watch,
+//      instead of spinning through empty polls.
 //----------------------------------------------------------------------
 void Interrupt::Idle() {
     DEBUG('i', "Machine idling; checking for interrupts.\n");
     status = IdleMode;
+    if ((numCompletions == 0) && (numWatched > 0) && !pending->IsEmpty()) {
+        // Only input can make a thread runnable again: rather than
+        // going through poll after poll, wait (on the host) for some.
+        DEBUG('i', "Waiting for input.\n");
+        WaitForInput(watched, numWatched);
+    }
     if (CheckIfDue(TRUE)) {       // check for any pending interrupts
         while (CheckIfDue(FALSE)) // check for any other pending
             ;                     // interrupts
         yieldOnReturn = FALSE;    // since there's nothing in the
-        // ready queue, the yield is automatic
+        sliceOver = FALSE;        // ready queue, the yield is automatic
         status = SystemMode;
         return; // return in case there's now
                 // a runnable thread
@@ -222,6 +488,27 @@ void Interrupt::Idle() {
     Halt();
 }
 
+//----------------------------------------------------------------------
+// Interrupt::WatchInput, Interrupt::IgnoreInput
+//      Called by the devices that poll a host file (or socket) for
+//      input, so that Idle knows where to wait for it.
+//
+//      "fd" -- the host file descriptor
+//----------------------------------------------------------------------
+
+void Interrupt::WatchInput(int fd) {
+    ASSERT(numWatched < MaxWatchedInputs);
+    watched[numWatched++] = fd;
+}
+
+void Interrupt::IgnoreInput(int fd) {
+    for (int i = 0; i < numWatched; i++)
+        if (watched[i] == fd) {
+            watched[i] = watched[--numWatched];
+            return;
+        }
+}
+
 //----------------------------------------------------------------------
 // Interrupt::Halt
 //      Shut down Nachos cleanly, printing out performance statistics.
@@ -229,6 +516,10 @@ void Interrupt::Idle() {
 void Interrupt::Halt() {
     printf("Machine halting!\n\n");
     stats->Print();
+#ifdef USER_PROGRAM
+    if (machine->profile != NULL)
+        machine->profile->Print();
+#endif
     Cleanup(); // Never returns.
 }
 
@@ -238,7 +529,7 @@ void Interrupt::Halt() {
 //      Arrange for the CPU to be interrupted when simulated time
 //      reaches "now + when".
 //
-//      Implementation: just put it on a sorted list.
+//      Implementation: just put it on the pending queue.
 //
 //      NOTE: the Nachos kernel should not call this routine directly.
 //      Instead, it is only called by the hardware device simulators.
@@ -258,7 +549,12 @@ void Interrupt::Schedule(VoidFunctionPtr handler, int arg, long long fromNow,
           intTypeNames[type], when);
     ASSERT(fromNow > 0);
 
-    pending->SortedInsert(toOccur, when);
+    CatchUpOrder(); // the new interrupt goes behind the others
+    pending->Insert(toOccur);
+    if (!IsPolling(type))
+        numCompletions++;
+    if (when < nextDue)
+        nextDue = when;
 }
 
 //----------------------------------------------------------------------
@@ -282,26 +578,33 @@ bool Interrupt::CheckIfDue(bool advanceClock) {
     // to invoke an interrupt handler
     if (DebugIsEnabled('i'))
         DumpState();
-    PendingInterrupt *toOccur =
-        (PendingInterrupt *)pending->SortedRemove(&when);
+    if (!advanceClock && (nextDue > stats->totalTicks)) {
+        if (!pending->IsEmpty())
+            putBacks++; // not time yet (see CatchUpOrder)
+        return FALSE;
+    }
+    CatchUpOrder();
+    PendingInterrupt *toOccur = pending->RemoveFirst();
 
     if (toOccur == NULL) // no pending interrupts
         return FALSE;
+    when = toOccur->when;
 
     if (advanceClock && when > stats->totalTicks) { // advance the clock
         stats->idleTicks += (when - stats->totalTicks);
         stats->totalTicks = when;
-    } else if (when > stats->totalTicks) { // not time yet, put it back
-        pending->SortedInsert(toOccur, when);
-        return FALSE;
     }
 
     // Check if there is nothing more to do, and if so, quit
     if ((status == IdleMode) && (toOccur->type == TimerInt) &&
         pending->IsEmpty()) {
-        pending->SortedInsert(toOccur, when);
+        pending->Insert(toOccur);
+        UpdateNextDue();
         return FALSE;
     }
+    UpdateNextDue(); // toOccur is off the list
+    if (!IsPolling(toOccur->type))
+        numCompletions--;
 
     DEBUG('i', "Invoking interrupt handler for the %s at time %d\n",
           intTypeNames[toOccur->type], toOccur->when);
@@ -333,6 +636,67 @@ static void PrintPending(int arg) {
            intTypeNames[pend->type], pend->when);
 }
 
+//----------------------------------------------------------------------
+// Interrupt::SavePending
+//      Record the type and deadline of each pending interrupt, so that a
+//      snapshot of the machine can be taken.  The handlers themselves
+//      are host addresses, which mean nothing to a later run of Nachos.
+//
+//      "types", "whens" -- where to store the records
+//      "max" -- how many records fit
+//
+// Returns:
+//      The number of records stored.
+//----------------------------------------------------------------------
+
+int Interrupt::SavePending(IntType *types, long long *whens, int max) {
+    int i;
+
+    CatchUpOrder();
+    for (i = 0; (i < pending->Count()) && (i < max); i++) {
+        types[i] = pending->Item(i)->type;
+        whens[i] = pending->Item(i)->when;
+    }
+    return i;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::RestorePending
+//      Give the interrupts pending now the deadlines recorded by
+//      SavePending.  The devices of this run scheduled their own
+//      interrupts when they were initialized; each one takes the
+//      deadline of a recorded interrupt of the same type, and the
+//      others keep their distance from the current time.
+//
+//      "types", "whens", "num" -- the records from SavePending
+//      "shift" -- how far the simulated clock was moved
+//----------------------------------------------------------------------
+
+void Interrupt::RestorePending(IntType *types, long long *whens, int num,
+                               long long shift) {
+    bool *used = new bool[num];
+    PendingInterrupt *toOccur;
+    int i, j;
+
+    CatchUpOrder();
+    for (j = 0; j < num; j++)
+        used[j] = FALSE;
+    for (i = 0; i < pending->Count(); i++) {
+        toOccur = pending->Item(i);
+        for (j = 0; j < num; j++)
+            if (!used[j] && (types[j] == toOccur->type))
+                break;
+        if (j < num) {
+            toOccur->when = whens[j];
+            used[j] = TRUE;
+        } else
+            toOccur->when += shift;
+    }
+    delete[] used;
+    pending->Rebuild();
+    UpdateNextDue();
+}
+
 //----------------------------------------------------------------------
 // DumpState
 //      Print the complete interrupt state - the status, and all interrupts
@@ -350,6 +714,7 @@ void Interrupt::DumpState() {
 
     printf("Pending interrupts:\n");
     fflush(stdout);
+    CatchUpOrder();
     pending->Mapcar(PrintPending);
     printf("End of pending interrupts\n");
     fflush(stdout);
@@ -37,6 +37,7 @@
 
 #include "copyright.h"
 #include "list.h"
+#include "objectpool.h"
 
 // Interrupts can be disabled (IntOff) or enabled (IntOn)
 enum IntStatus { IntOff, IntOn };
@@ -58,6 +59,13 @@ enum IntType {
     NetworkRecvInt
 };
 
+// Most host files a device can ask Idle to wait on (see WatchInput)
+#define MaxWatchedInputs 4
+
+// Deadline used when no interrupt is pending: simulated time never gets
+// that far.
+#define NeverDue 0x7fffffffffffffffLL
+
 // The following class defines an interrupt that is scheduled
 // to occur in the future.  The internal data structures are
 // left public to make it simpler to manipulate.
@@ -69,11 +77,57 @@ class PendingInterrupt {
     // initialize an interrupt that will
     // occur in the future
 
+    void *operator new(size_t size); // pending interrupts come from
+    void operator delete(void *p);   // pendingInterruptPool
+
     VoidFunctionPtr handler; // The function (in the hardware device
     // emulator) to call when the interrupt occurs
     int arg;        // The argument to the function.
     long long when; // When the interrupt is supposed to fire
     IntType type;   // for debugging
+    unsigned int order; // Set by PendingQueue: breaks ties between
+    // interrupts due at the same time
+};
+
+// The following class defines the queue of interrupts scheduled to occur,
+// ordered by "when", and in the order they were inserted among those due
+// at the same time.  It is a binary min-heap, so Insert and RemoveFirst
+// take O(log n) steps, where the sorted List took O(n).  (Rotate keeps
+// the order the List used to put interrupts due at the same time in.)
+
+class PendingQueue {
+  public:
+    PendingQueue();  // initialize an empty queue
+    ~PendingQueue(); // de-allocate the queue (not the interrupts)
+
+    void Insert(PendingInterrupt *toOccur); // Put an interrupt on the queue
+    PendingInterrupt *RemoveFirst(); // Take off the earliest interrupt,
+    // NULL if the queue is empty
+    PendingInterrupt *First() { return (count > 0) ? heap[0] : NULL; }
+    // Look at the earliest interrupt
+
+    bool IsEmpty() { return count == 0; }
+    int Count() { return count; }
+
+    PendingInterrupt *Item(int i) { return heap[i]; } // The "i"th
+    // interrupt, in no particular order
+    void Rebuild(); // Restore the heap order after the
+    // "when" of some interrupts was changed
+    void Rotate(long long times); // Move the earliest interrupt behind
+    // the others due at the same time, "times" times over
+
+    void Mapcar(VoidFunctionPtr func); // Apply "func" to every interrupt,
+    // earliest first (for debugging)
+
+  private:
+    PendingInterrupt **heap; // heap[i] is due no later than its
+    // children heap[2i+1] and heap[2i+2]
+    int count;               // number of interrupts in the heap
+    int size;                // number of slots allocated
+    unsigned int nextOrder;  // "order" of the next inserted interrupt
+
+    int CountDue(int i, long long when); // Interrupts due at "when"
+    // in the subtree of heap[i]
 };
 
 // The following class defines the data structures for the simulation
@@ -99,14 +153,27 @@ class Interrupt {
 
     void Halt(); // quit and print out stats
 
-    void YieldOnReturn(); // cause a context switch on return
-    // from an interrupt handler
+    void WatchInput(int fd);  // Idle may wait for input on this host
+    void IgnoreInput(int fd); // file (or socket), or not any more
+
+    void YieldOnReturn(bool endOfSlice = TRUE); // cause a context switch
+    // on return from an interrupt handler,
+    // because the time slice is over or not
+    bool InHandler() { return inHandler; } // running an interrupt
+    // handler?
 
     MachineStatus getStatus() { return status; } // idle, kernel, user
     void setStatus(MachineStatus st) { status = st; }
 
     void DumpState(); // Print interrupt state
 
+    int SavePending(IntType *types, long long *whens, int max);
+    // Record when each pending interrupt is due
+    void RestorePending(IntType *types, long long *whens, int num,
+                        long long shift);
+    // Make the pending interrupts due at the
+    // recorded times (see snapshot.cc)
+
     // NOTE: the following are internal to the hardware simulation code.
     // DO NOT call these directly.  I should make them "private",
     // but they need to be public since they are called by the
@@ -119,19 +186,42 @@ class Interrupt {
 
     void OneTick(); // Advance simulated time
 
+    long long NextDueTime() { return nextDue; }
+    // When the earliest pending interrupt is
+    // due to fire, or NeverDue
+    void TickNotDue() { putBacks++; } // Account for a tick before
+    // NextDueTime that skipped OneTick (see
+    // Machine::RunBlock)
+
   private:
     IntStatus level; // are interrupts enabled or disabled?
-    List *pending;   // the list of interrupts scheduled
+    PendingQueue *pending; // the interrupts scheduled
     // to occur in the future
+    int numCompletions; // pending interrupts that are not input
+    // polls or timer ticks: while there are
+    // some, Idle cannot wait for input
+    int watched[MaxWatchedInputs]; // host files polled by the devices
+    int numWatched;
+    long long nextDue; // "when" of the head of pending, kept up
+    // to date so OneTick can tell at a glance
+    // that nothing is due
+    long long putBacks; // checks that found nothing due since the
+    // order of pending was last brought up
+    // to date (see CatchUpOrder)
     bool inHandler;     // TRUE if we are running an interrupt handler
     bool yieldOnReturn; // TRUE if we are to context switch
     // on return from the interrupt handler
+    bool sliceOver; // ... because the time slice of the
+    // interrupted thread is over (otherwise,
+    // to run a thread a handler woke up)
     MachineStatus status; // idle, kernel mode, user mode
 
     // these functions are internal to the interrupt simulation code
 
     bool CheckIfDue(bool advanceClock); // Check if an interrupt is supposed
     // to occur now
+    void UpdateNextDue(); // Recompute nextDue from pending
+    void CatchUpOrder();  // Apply putBacks to pending
 
     void ChangeLevel(IntStatus old,  // SetLevel, without advancing the
                      IntStatus now); // simulated time
@@ -8,6 +8,7 @@
 // of liability and disclaimer of warranty provisions.
 
 #include "machine.h"
+#include "profile.h"
 #include "copyright.h"
 #include "system.h"
 
@@ -52,9 +53,13 @@ static void CheckEndian() {
 //
 //      "debug" -- if TRUE, drop into the debugger after each user instruction
 //              is executed.
+//      "blockEngine" -- if TRUE, run user code a basic block at a time instead
+//              of through the instruction interpreter.
+//      "tlbEntries" -- the size of the TLB, if the machine has one
+//              (USE_TLB).
 //----------------------------------------------------------------------
 
-Machine::Machine(bool debug) {
+Machine::Machine(bool debug, bool blockEngine, int tlbEntries) {
     int i;
 
     for (i = 0; i < NumTotalRegs; i++)
@@ -62,17 +67,37 @@ Machine::Machine(bool debug) {
     mainMemory = new char[MemorySize];
     for (i = 0; i < MemorySize; i++)
         mainMemory[i] = 0;
+    decodedInstrs = new Instruction[NumInstrSlots];
+    for (i = 0; i < NumInstrSlots; i++)
+        decodedInstrs[i].opCode = NotDecoded;
+    FlushTranslationCache();
+    blocks = new BasicBlock *[NumInstrSlots];
+    for (i = 0; i < NumInstrSlots; i++)
+        blocks[i] = NULL;
+    for (i = 0; i < NumPhysPages; i++)
+        frameGeneration[i] = 0;
+    tlbSize = tlbEntries;
+    tlbHits = 0;
 #ifdef USE_TLB
-    tlb = new TranslationEntry[TLBSize];
-    for (i = 0; i < TLBSize; i++)
+    ASSERT(tlbSize > 0);
+    tlb = new TranslationEntry[tlbSize];
+    tlbLastUse = new unsigned int[tlbSize];
+    for (i = 0; i < tlbSize; i++) {
         tlb[i].valid = FALSE;
+        tlbLastUse[i] = 0;
+    }
     pageTable = NULL;
 #else // use linear page table
     tlb = NULL;
+    tlbLastUse = NULL;
     pageTable = NULL;
 #endif
 
+    profile = NULL;
+    linkAddress = -1;
     singleStep = debug;
+    // the block engine skips the per-instruction tracing of 'm' and 'i'
+    useBlocks = blockEngine && !DebugIsEnabled('m') && !DebugIsEnabled('i');
     CheckEndian();
 }
 
@@ -83,8 +108,14 @@ Machine::Machine(bool debug) {
 
 Machine::~Machine() {
     delete[] mainMemory;
-    if (tlb != NULL)
+    delete[] decodedInstrs;
+    FreeBlocks();
+    delete[] blocks;
+    if (tlb != NULL) {
         delete[] tlb;
+        delete[] tlbLastUse;
+    }
+    delete profile;
 }
 
 //----------------------------------------------------------------------
@@ -98,14 +129,37 @@ Machine::~Machine() {
 //----------------------------------------------------------------------
 
 void Machine::RaiseException(ExceptionType which, int badVAddr) {
+    MachineStatus oldStatus = interrupt->getStatus(); // SystemMode if the
+    // kernel took a page fault while copying from user memory
     DEBUG('m', "Exception: %s\n", exceptionNames[which]);
 
     //  ASSERT(interrupt->getStatus() == UserMode);
+    if ((profile != NULL) && (which == SyscallException))
+        profile->CountSyscall(registers[2]);
     registers[BadVAddrReg] = badVAddr;
+    linkAddress = -1;  // the kernel may change memory behind LL/SC
     DelayedLoad(0, 0); // finish anything in progress
     interrupt->setStatus(SystemMode);
     ExceptionHandler(which); // interrupts are enabled at this point
-    interrupt->setStatus(UserMode);
+    interrupt->setStatus(oldStatus);
+}
+
+//----------------------------------------------------------------------
+// Machine::InvalidateDecodedFrame
+//      Forget the decoded instructions cached for a physical page.
+//      Must be called whenever the kernel changes the contents of a
+//      frame behind the simulator's back (WriteMem already takes care
+//      of stores done by user code).
+//
+//      "frame" -- the physical page number
+//----------------------------------------------------------------------
+
+void Machine::InvalidateDecodedFrame(int frame) {
+    ASSERT((frame >= 0) && (frame < NumPhysPages));
+    Instruction *slot = &decodedInstrs[frame * (PageSize / 4)];
+    for (int i = 0; i < PageSize / 4; i++)
+        slot[i].opCode = NotDecoded;
+    frameGeneration[frame]++;
 }
 
 //----------------------------------------------------------------------
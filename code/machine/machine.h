@@ -35,7 +35,8 @@
 
 #define NumPhysPages 250
 #define MemorySize (NumPhysPages * PageSize)
-#define TLBSize 4 // if there is a TLB, make it small
+#define TLBSize 4 // if there is a TLB, make it small (the
+                  // default number of entries, see "-tlb")
 
 enum ExceptionType {
     NoException,        // Everything ok!
@@ -93,6 +94,32 @@ class Instruction {
     // Immediates are sign-extended.
 };
 
+// Decoded instructions are cached, one slot per word of physical memory.
+// A slot whose opCode is NotDecoded has to be fetched and decoded again.
+#define NotDecoded 0
+#define NumInstrSlots (MemorySize / 4)
+
+// Recent translations are cached on the host side, direct-mapped by
+// virtual page, so that a load, store or fetch that hits skips Translate.
+// A page enters the read cache once its use bit is set, and the write
+// cache once its dirty bit is set too, so a hit has no bits to update.
+#define TranslationCacheSize 32 // must be a power of two
+
+class CachedTranslation {
+  public:
+    int virtualPage; // -1 if the slot is empty
+    int physBase;    // physical address of the page in mainMemory
+    int tlbEntry;    // TLB entry it came from, if there is a TLB
+};
+
+// A run of straight-line user code prepared for the basic-block engine
+// ("-bb"); defined in mipssim.cc.
+struct BasicBlock;
+
+// The counters kept when user programs are profiled ("-prof"); defined
+// in profile.h.
+class Profile;
+
 // The following class defines the simulated host workstation hardware, as
 // seen by user programs -- the CPU registers, main memory, etc.
 // User programs shouldn't be able to tell that they are running on our
@@ -108,8 +135,9 @@ class Instruction {
 
 class Machine {
   public:
-    Machine(bool debug); // Initialize the simulation of the hardware
-                         // for running user programs
+    Machine(bool debug, bool blockEngine, int tlbEntries = TLBSize);
+    // Initialize the simulation of the
+    // hardware for running user programs
     ~Machine();          // De-allocate the data structures
 
     // Routines callable by the Nachos kernel
@@ -122,8 +150,15 @@ class Machine {
 
     // Routines internal to the machine simulation -- DO NOT call these
 
-    void OneInstruction(Instruction *instr);
-    // Run one instruction of a user program.
+    void OneInstruction(); // Run one instruction of a user program.
+    Instruction *FetchInstruction();
+    // Return the decoded instruction at PC,
+    // or NULL if the fetch raised an exception
+    void RunBlock(); // Run user instructions up to the end of
+    // the basic block starting at PC
+    BasicBlock *BuildBlock(int physAddr);
+    // Prepare the block starting at physAddr
+    void FreeBlocks(); // Delete every prepared block
     void DelayedLoad(int nextReg, int nextVal);
     // Do a pending delayed load (modifying a reg)
 
@@ -141,6 +176,16 @@ class Machine {
     // and return an exception code if the
     // translation couldn't be completed.
 
+    void FlushTranslationCache();
+    // Forget the cached translations.  Must be
+    // called whenever the page table pointer,
+    // a TranslationEntry or the TLB changes
+
+    void InvalidateDecodedFrame(int frame);
+    // Drop the cached decoded instructions
+    // of a physical page whose contents are
+    // about to be replaced
+
     void RaiseException(ExceptionType which, int badVAddr);
     // Trap to the Nachos kernel, because of a
     // system call or other exception.
@@ -179,11 +224,44 @@ class Machine {
 
     TranslationEntry *tlb; // this pointer should be considered
     // "read-only" to Nachos kernel code
+    int tlbSize; // number of entries in "tlb"
+    unsigned int *tlbLastUse; // when each TLB entry was last used
+    // (a count of TLB hits), for the LRU
+    // replacement of the kernel; read-only
 
     TranslationEntry *pageTable;
     unsigned int pageTableSize;
 
+    Profile *profile; // counts user instructions, memory accesses
+    // and system calls, if non-NULL
+
+    int linkAddress; // address of the last LL, or -1 once an
+    // exception or a context switch has broken
+    // the link: an SC to it only succeeds if not
+
   private:
+    bool LookupCache(CachedTranslation *cache, int virtAddr, int size,
+                     int *physAddr);
+    // Look an address up in a translation
+    // cache (defined in translate.cc)
+
+    CachedTranslation readCache[TranslationCacheSize];
+    CachedTranslation writeCache[TranslationCacheSize];
+    // translations known to be readable,
+    // and known to be writable
+
+    unsigned int tlbHits; // stamp of the last TLB hit
+
+    Instruction *decodedInstrs; // decode cache, indexed by physical
+    // word (physical address / 4)
+
+    bool useBlocks;      // run user code through RunBlock
+    BasicBlock **blocks; // block cache, indexed like decodedInstrs
+    unsigned int frameGeneration[NumPhysPages];
+    // bumped whenever code of a frame is
+    // written; blocks built from an older
+    // generation are stale
+
     bool singleStep; // drop back into the debugger after each
     // simulated instruction
     int runUntilTime; // drop back into the debugger when simulated
@@ -14,6 +14,7 @@
 
 #include "machine.h"
 #include "mipssim.h"
+#include "profile.h"
 #include "system.h"
 
 static void Mult(int a, int b, bool signedArith, int *hiPtr, int *loPtr);
@@ -25,16 +26,12 @@ static void Mult(int a, int b, bool signedArith, int *hiPtr, int *loPtr);
 //
 //      This routine is re-entrant, in that it can be called multiple
 //      times concurrently -- one for each thread executing user code.
+//
+//      With "-bb", user code goes through RunBlock, a basic block at a
+//      time, except while single-stepping in the debugger.
 //----------------------------------------------------------------------
 
 void Machine::Run() {
-    // LB: Using a dynamic instr is right here as one never exits this
-    // function.
-    // Instruction *instr = new Instruction;  // storage for decoded instruction
-    Instruction the_instr;
-    Instruction *instr = &the_instr;
-    // End of Modification
-
     if (DebugIsEnabled('m'))
 
         // LB: Update the print format after the promotion of tick types
@@ -47,8 +44,12 @@ void Machine::Run() {
 
     interrupt->setStatus(UserMode);
     for (;;) {
-        OneInstruction(instr);
-        interrupt->OneTick();
+        if (useBlocks && !singleStep)
+            RunBlock();
+        else {
+            OneInstruction();
+            interrupt->OneTick();
+        }
         if (singleStep && (runUntilTime <= stats->totalTicks))
             Debugger();
     }
@@ -74,6 +75,27 @@ static int TypeToReg(RegType reg, Instruction *instr) {
     }
 }
 
+//----------------------------------------------------------------------
+// OpcodeName
+//      Return the mnemonic of an opcode (the first word of its entry in
+//      opStrings), for the profile report.  The result is overwritten by
+//      the next call.
+//----------------------------------------------------------------------
+
+const char *OpcodeName(int opCode) {
+    static char name[16];
+    const char *format = opStrings[opCode].string;
+    unsigned int i;
+
+    ASSERT((opCode >= 0) && (opCode <= MaxOpcode));
+    for (i = 0; (i < sizeof(name) - 1) && (format[i] != '\0') &&
+                (format[i] != ' ');
+         i++)
+        name[i] = format[i];
+    name[i] = '\0';
+    return name;
+}
+
 //----------------------------------------------------------------------
 // Machine::OneInstruction
 //      Execute one instruction from a user-level program
@@ -94,20 +116,21 @@ static int TypeToReg(RegType reg, Instruction *instr) {
 //      store all data back to the machine registers and memory before
 //      leaving.  This allows the Nachos kernel to control our behavior
 //      by controlling the contents of memory, the translation table,
-//      and the register set.
+//      and the register set.  (The decode cache is the one exception;
+//      it is keyed by physical address and invalidated on every write,
+//      so it always reflects the contents of memory.)
 //----------------------------------------------------------------------
 
-void Machine::OneInstruction(Instruction *instr) {
-    int raw;
+void Machine::OneInstruction() {
+    Instruction *instr;
     int nextLoadReg = 0;
     int nextLoadValue = 0; // record delayed load operation, to apply
     // in the future
 
     // Fetch instruction
-    if (!machine->ReadMem(registers[PCReg], 4, &raw))
+    instr = FetchInstruction();
+    if (instr == NULL)
         return; // exception occurred
-    instr->value = raw;
-    instr->Decode();
 
     if (DebugIsEnabled('m')) {
         struct OpString *str = &opStrings[instr->opCode];
@@ -118,6 +141,8 @@ void Machine::OneInstruction(Instruction *instr) {
                TypeToReg(str->args[1], instr), TypeToReg(str->args[2], instr));
         printf("\n");
     }
+    if (profile != NULL)
+        profile->CountInstruction(registers[PCReg], instr->opCode);
 
     // Compute next pc, but don't install in case there's an error or branch.
     int pcAfter = registers[NextPCReg] + 4;
@@ -239,7 +264,7 @@ void Machine::OneInstruction(Instruction *instr) {
     case OP_LB:
     case OP_LBU:
         tmp = registers[instr->rs] + instr->extra;
-        if (!machine->ReadMem(tmp, 1, &value))
+        if (!ReadMem(tmp, 1, &value))
             return;
 
         if ((value & 0x80) && (instr->opCode == OP_LB))
@@ -257,7 +282,7 @@ void Machine::OneInstruction(Instruction *instr) {
             RaiseException(AddressErrorException, tmp);
             return;
         }
-        if (!machine->ReadMem(tmp, 2, &value))
+        if (!ReadMem(tmp, 2, &value))
             return;
 
         if ((value & 0x8000) && (instr->opCode == OP_LH))
@@ -279,12 +304,25 @@ void Machine::OneInstruction(Instruction *instr) {
             RaiseException(AddressErrorException, tmp);
             return;
         }
-        if (!machine->ReadMem(tmp, 4, &value))
+        if (!ReadMem(tmp, 4, &value))
             return;
         nextLoadReg = instr->rt;
         nextLoadValue = value;
         break;
 
+    case OP_LL:
+        tmp = registers[instr->rs] + instr->extra;
+        if (tmp & 0x3) {
+            RaiseException(AddressErrorException, tmp);
+            return;
+        }
+        if (!ReadMem(tmp, 4, &value))
+            return;
+        nextLoadReg = instr->rt; // through the load delay slot, as LW:
+        nextLoadValue = value;   // a load still pending to rt would
+        linkAddress = tmp;       // otherwise overwrite the value
+        break;
+
     case OP_LWL:
         tmp = registers[instr->rs] + instr->extra;
 
@@ -293,7 +331,7 @@ void Machine::OneInstruction(Instruction *instr) {
         // fail (I think) if the other cases are ever exercised.
         ASSERT((tmp & 0x3) == 0);
 
-        if (!machine->ReadMem(tmp, 4, &value))
+        if (!ReadMem(tmp, 4, &value))
             return;
         if (registers[LoadReg] == instr->rt)
             nextLoadValue = registers[LoadValueReg];
@@ -324,7 +362,7 @@ void Machine::OneInstruction(Instruction *instr) {
         // fail (I think) if the other cases are ever exercised.
         ASSERT((tmp & 0x3) == 0);
 
-        if (!machine->ReadMem(tmp, 4, &value))
+        if (!ReadMem(tmp, 4, &value))
             return;
         if (registers[LoadReg] == instr->rt)
             nextLoadValue = registers[LoadValueReg];
@@ -392,14 +430,14 @@ void Machine::OneInstruction(Instruction *instr) {
         break;
 
     case OP_SB:
-        if (!machine->WriteMem((unsigned)(registers[instr->rs] + instr->extra),
-                               1, registers[instr->rt]))
+        if (!WriteMem((unsigned)(registers[instr->rs] + instr->extra), 1,
+                      registers[instr->rt]))
             return;
         break;
 
     case OP_SH:
-        if (!machine->WriteMem((unsigned)(registers[instr->rs] + instr->extra),
-                               2, registers[instr->rt]))
+        if (!WriteMem((unsigned)(registers[instr->rs] + instr->extra), 2,
+                      registers[instr->rt]))
             return;
         break;
 
@@ -517,9 +555,27 @@ void Machine::OneInstruction(Instruction *instr) {
         registers[instr->rd] = registers[instr->rs] - registers[instr->rt];
         break;
 
+    case OP_SC:
+        // store only if nothing could have changed the word since the LL
+        // (no exception, no context switch): rt tells whether it did
+        tmp = registers[instr->rs] + instr->extra;
+        if (tmp & 0x3) {
+            RaiseException(AddressErrorException, tmp);
+            return;
+        }
+        if (tmp != linkAddress)
+            registers[instr->rt] = 0;
+        else {
+            if (!WriteMem(tmp, 4, registers[instr->rt]))
+                return;
+            registers[instr->rt] = 1;
+        }
+        linkAddress = -1;
+        break;
+
     case OP_SW:
-        if (!machine->WriteMem((unsigned)(registers[instr->rs] + instr->extra),
-                               4, registers[instr->rt]))
+        if (!WriteMem((unsigned)(registers[instr->rs] + instr->extra), 4,
+                      registers[instr->rt]))
             return;
         break;
 
@@ -530,7 +586,7 @@ void Machine::OneInstruction(Instruction *instr) {
         // fail (I think) if the other cases are ever exercised.
         ASSERT((tmp & 0x3) == 0);
 
-        if (!machine->ReadMem((tmp & ~0x3), 4, &value))
+        if (!ReadMem((tmp & ~0x3), 4, &value))
             return;
         switch (tmp & 0x3) {
         case 0:
@@ -549,7 +605,7 @@ void Machine::OneInstruction(Instruction *instr) {
                 (value & 0xffffff00) | ((registers[instr->rt] >> 24) & 0xff);
             break;
         }
-        if (!machine->WriteMem((tmp & ~0x3), 4, value))
+        if (!WriteMem((tmp & ~0x3), 4, value))
             return;
         break;
 
@@ -560,7 +616,7 @@ void Machine::OneInstruction(Instruction *instr) {
         // fail (I think) if the other cases are ever exercised.
         ASSERT((tmp & 0x3) == 0);
 
-        if (!machine->ReadMem((tmp & ~0x3), 4, &value))
+        if (!ReadMem((tmp & ~0x3), 4, &value))
             return;
         switch (tmp & 0x3) {
         case 0:
@@ -576,7 +632,7 @@ void Machine::OneInstruction(Instruction *instr) {
             value = registers[instr->rt];
             break;
         }
-        if (!machine->WriteMem((tmp & ~0x3), 4, value))
+        if (!WriteMem((tmp & ~0x3), 4, value))
             return;
         break;
 
@@ -602,6 +658,9 @@ void Machine::OneInstruction(Instruction *instr) {
     }
 
     // Now we have successfully executed the instruction.
+    if ((profile != NULL) &&
+        ((instr->opCode == OP_JAL) || (instr->opCode == OP_JALR)))
+        profile->CountCall(registers[PCReg], pcAfter);
 
     // Do any delayed load operation
     DelayedLoad(nextLoadReg, nextLoadValue);
@@ -613,6 +672,42 @@ void Machine::OneInstruction(Instruction *instr) {
     registers[NextPCReg] = pcAfter;
 }
 
+//----------------------------------------------------------------------
+// Machine::FetchInstruction
+//      Return the decoded form of the instruction at PC.
+//
+//      The translated fetch address selects a slot in the decode cache;
+//      the word is only read out of memory and decoded the first time
+//      it is executed after being loaded, so tight loops skip Decode
+//      entirely.  Stores (WriteMem) and frame reallocation
+//      (InvalidateDecodedFrame) reset the slots they make stale.
+//
+//      The returned instruction belongs to the cache: it must not be
+//      used after anything that may run other user code (an exception).
+//
+// Returns:
+//      NULL if the fetch raised an exception.
+//----------------------------------------------------------------------
+
+Instruction *Machine::FetchInstruction() {
+    ExceptionType exception;
+    int physAddr;
+    Instruction *instr;
+
+    exception = Translate(registers[PCReg], &physAddr, 4, FALSE);
+    if (exception != NoException) {
+        RaiseException(exception, registers[PCReg]);
+        return NULL;
+    }
+
+    instr = &decodedInstrs[physAddr >> 2];
+    if (instr->opCode == NotDecoded) {
+        instr->value = WordToHost(*(unsigned int *)&mainMemory[physAddr]);
+        instr->Decode();
+    }
+    return instr;
+}
+
 //----------------------------------------------------------------------
 // Machine::DelayedLoad
 //      Simulate effects of a delayed load.
@@ -733,3 +828,835 @@ static void Mult(int a, int b, bool signedArith, int *hiPtr, int *loPtr) {
     *hiPtr = (int)hi;
     *loPtr = (int)lo;
 }
+
+//----------------------------------------------------------------------
+// The basic-block engine
+//
+//      A basic block is the run of instructions starting at some PC up
+//      to and including the delay slot of the first branch or jump, or
+//      up to a syscall, or up to the end of the physical page.  Each
+//      instruction is bound once, when the block is built, to the
+//      handler that executes its opcode; running the block is then a
+//      loop through handler pointers, with no fetch, no translation and
+//      no switch on the opcode.
+//
+//      The handlers are exactly the cases of OneInstruction's switch:
+//      they compute the next PC and the delayed load, and return FALSE
+//      after raising an exception, leaving the PCs untouched, as the
+//      interpreter does.  Run it both ways ("-bb" or not) to compare.
+//----------------------------------------------------------------------
+
+// What an instruction hands back to RunBlock for it to install.
+struct ExecState {
+    int pcAfter;       // value for NextPCReg
+    int nextLoadReg;   // delayed load to start
+    int nextLoadValue;
+};
+
+typedef bool (*InstrHandler)(Machine *m, Instruction *instr, ExecState *st);
+
+// One instruction of a block: its handler and a private copy of its
+// decoded form (the decode cache slot may be reused while we run).
+struct BlockOp {
+    InstrHandler handler;
+    Instruction instr;
+};
+
+struct BasicBlock {
+    int frame;                // physical page holding the code
+    unsigned int generation;  // frameGeneration[frame] when built
+    int length;               // number of ops
+    BlockOp ops[PageSize / 4];
+};
+
+static bool DoAdd(Machine *m, Instruction *instr, ExecState *st) {
+    int *r = m->registers;
+    int sum = r[instr->rs] + r[instr->rt];
+
+    if (!((r[instr->rs] ^ r[instr->rt]) & SIGN_BIT) &&
+        ((r[instr->rs] ^ sum) & SIGN_BIT)) {
+        m->RaiseException(OverflowException, 0);
+        return FALSE;
+    }
+    r[instr->rd] = sum;
+    return TRUE;
+}
+
+static bool DoAddi(Machine *m, Instruction *instr, ExecState *st) {
+    int *r = m->registers;
+    int sum = r[instr->rs] + instr->extra;
+
+    if (!((r[instr->rs] ^ instr->extra) & SIGN_BIT) &&
+        ((instr->extra ^ sum) & SIGN_BIT)) {
+        m->RaiseException(OverflowException, 0);
+        return FALSE;
+    }
+    r[instr->rt] = sum;
+    return TRUE;
+}
+
+static bool DoAddiu(Machine *m, Instruction *instr, ExecState *st) {
+    m->registers[instr->rt] = m->registers[instr->rs] + instr->extra;
+    return TRUE;
+}
+
+static bool DoAddu(Machine *m, Instruction *instr, ExecState *st) {
+    int *r = m->registers;
+    r[instr->rd] = r[instr->rs] + r[instr->rt];
+    return TRUE;
+}
+
+static bool DoAnd(Machine *m, Instruction *instr, ExecState *st) {
+    int *r = m->registers;
+    r[instr->rd] = r[instr->rs] & r[instr->rt];
+    return TRUE;
+}
+
+static bool DoAndi(Machine *m, Instruction *instr, ExecState *st) {
+    m->registers[instr->rt] = m->registers[instr->rs] & (instr->extra & 0xffff);
+    return TRUE;
+}
+
+static bool DoBeq(Machine *m, Instruction *instr, ExecState *st) {
+    int *r = m->registers;
+    if (r[instr->rs] == r[instr->rt])
+        st->pcAfter = r[NextPCReg] + IndexToAddr(instr->extra);
+    return TRUE;
+}
+
+static bool DoBgez(Machine *m, Instruction *instr, ExecState *st) {
+    int *r = m->registers;
+    if (!(r[instr->rs] & SIGN_BIT))
+        st->pcAfter = r[NextPCReg] + IndexToAddr(instr->extra);
+    return TRUE;
+}
+
+static bool DoBgezal(Machine *m, Instruction *instr, ExecState *st) {
+    m->registers[R31] = m->registers[NextPCReg] + 4;
+    return DoBgez(m, instr, st);
+}
+
+static bool DoBgtz(Machine *m, Instruction *instr, ExecState *st) {
+    int *r = m->registers;
+    if (r[instr->rs] > 0)
+        st->pcAfter = r[NextPCReg] + IndexToAddr(instr->extra);
+    return TRUE;
+}
+
+static bool DoBlez(Machine *m, Instruction *instr, ExecState *st) {
+    int *r = m->registers;
+    if (r[instr->rs] <= 0)
+        st->pcAfter = r[NextPCReg] + IndexToAddr(instr->extra);
+    return TRUE;
+}
+
+static bool DoBltz(Machine *m, Instruction *instr, ExecState *st) {
+    int *r = m->registers;
+    if (r[instr->rs] & SIGN_BIT)
+        st->pcAfter = r[NextPCReg] + IndexToAddr(instr->extra);
+    return TRUE;
+}
+
+static bool DoBltzal(Machine *m, Instruction *instr, ExecState *st) {
+    m->registers[R31] = m->registers[NextPCReg] + 4;
+    return DoBltz(m, instr, st);
+}
+
+static bool DoBne(Machine *m, Instruction *instr, ExecState *st) {
+    int *r = m->registers;
+    if (r[instr->rs] != r[instr->rt])
+        st->pcAfter = r[NextPCReg] + IndexToAddr(instr->extra);
+    return TRUE;
+}
+
+static bool DoDiv(Machine *m, Instruction *instr, ExecState *st) {
+    int *r = m->registers;
+    if (r[instr->rt] == 0) {
+        r[LoReg] = 0;
+        r[HiReg] = 0;
+    } else {
+        r[LoReg] = r[instr->rs] / r[instr->rt];
+        r[HiReg] = r[instr->rs] % r[instr->rt];
+    }
+    return TRUE;
+}
+
+static bool DoDivu(Machine *m, Instruction *instr, ExecState *st) {
+    int *r = m->registers;
+    unsigned int rs = (unsigned int)r[instr->rs];
+    unsigned int rt = (unsigned int)r[instr->rt];
+    int tmp;
+
+    if (rt == 0) {
+        r[LoReg] = 0;
+        r[HiReg] = 0;
+    } else {
+        tmp = rs / rt;
+        r[LoReg] = (int)tmp;
+        tmp = rs % rt;
+        r[HiReg] = (int)tmp;
+    }
+    return TRUE;
+}
+
+static bool DoJ(Machine *m, Instruction *instr, ExecState *st) {
+    st->pcAfter = (st->pcAfter & 0xf0000000) | IndexToAddr(instr->extra);
+    return TRUE;
+}
+
+static bool DoJal(Machine *m, Instruction *instr, ExecState *st) {
+    m->registers[R31] = m->registers[NextPCReg] + 4;
+    return DoJ(m, instr, st);
+}
+
+static bool DoJr(Machine *m, Instruction *instr, ExecState *st) {
+    st->pcAfter = m->registers[instr->rs];
+    return TRUE;
+}
+
+static bool DoJalr(Machine *m, Instruction *instr, ExecState *st) {
+    m->registers[instr->rd] = m->registers[NextPCReg] + 4;
+    return DoJr(m, instr, st);
+}
+
+static bool DoLb(Machine *m, Instruction *instr, ExecState *st) {
+    int tmp = m->registers[instr->rs] + instr->extra;
+    int value;
+
+    if (!m->ReadMem(tmp, 1, &value))
+        return FALSE;
+    if ((value & 0x80) && (instr->opCode == OP_LB))
+        value |= 0xffffff00;
+    else
+        value &= 0xff;
+    st->nextLoadReg = instr->rt;
+    st->nextLoadValue = value;
+    return TRUE;
+}
+
+static bool DoLh(Machine *m, Instruction *instr, ExecState *st) {
+    int tmp = m->registers[instr->rs] + instr->extra;
+    int value;
+
+    if (tmp & 0x1) {
+        m->RaiseException(AddressErrorException, tmp);
+        return FALSE;
+    }
+    if (!m->ReadMem(tmp, 2, &value))
+        return FALSE;
+    if ((value & 0x8000) && (instr->opCode == OP_LH))
+        value |= 0xffff0000;
+    else
+        value &= 0xffff;
+    st->nextLoadReg = instr->rt;
+    st->nextLoadValue = value;
+    return TRUE;
+}
+
+static bool DoLui(Machine *m, Instruction *instr, ExecState *st) {
+    m->registers[instr->rt] = instr->extra << 16;
+    return TRUE;
+}
+
+static bool DoLw(Machine *m, Instruction *instr, ExecState *st) {
+    int tmp = m->registers[instr->rs] + instr->extra;
+    int value;
+
+    if (tmp & 0x3) {
+        m->RaiseException(AddressErrorException, tmp);
+        return FALSE;
+    }
+    if (!m->ReadMem(tmp, 4, &value))
+        return FALSE;
+    st->nextLoadReg = instr->rt;
+    st->nextLoadValue = value;
+    return TRUE;
+}
+
+static bool DoLwl(Machine *m, Instruction *instr, ExecState *st) {
+    int *r = m->registers;
+    int tmp = r[instr->rs] + instr->extra;
+    int value, nextLoadValue;
+
+    // Same restriction as in OneInstruction.
+    ASSERT((tmp & 0x3) == 0);
+
+    if (!m->ReadMem(tmp, 4, &value))
+        return FALSE;
+    if (r[LoadReg] == instr->rt)
+        nextLoadValue = r[LoadValueReg];
+    else
+        nextLoadValue = r[instr->rt];
+    switch (tmp & 0x3) {
+    case 0:
+        nextLoadValue = value;
+        break;
+    case 1:
+        nextLoadValue = (nextLoadValue & 0xff) | (value << 8);
+        break;
+    case 2:
+        nextLoadValue = (nextLoadValue & 0xffff) | (value << 16);
+        break;
+    case 3:
+        nextLoadValue = (nextLoadValue & 0xffffff) | (value << 24);
+        break;
+    }
+    st->nextLoadReg = instr->rt;
+    st->nextLoadValue = nextLoadValue;
+    return TRUE;
+}
+
+static bool DoLwr(Machine *m, Instruction *instr, ExecState *st) {
+    int *r = m->registers;
+    int tmp = r[instr->rs] + instr->extra;
+    int value, nextLoadValue;
+
+    // Same restriction as in OneInstruction.
+    ASSERT((tmp & 0x3) == 0);
+
+    if (!m->ReadMem(tmp, 4, &value))
+        return FALSE;
+    if (r[LoadReg] == instr->rt)
+        nextLoadValue = r[LoadValueReg];
+    else
+        nextLoadValue = r[instr->rt];
+    switch (tmp & 0x3) {
+    case 0:
+        nextLoadValue = (nextLoadValue & 0xffffff00) | ((value >> 24) & 0xff);
+        break;
+    case 1:
+        nextLoadValue =
+            (nextLoadValue & 0xffff0000) | ((value >> 16) & 0xffff);
+        break;
+    case 2:
+        nextLoadValue =
+            (nextLoadValue & 0xff000000) | ((value >> 8) & 0xffffff);
+        break;
+    case 3:
+        nextLoadValue = value;
+        break;
+    }
+    st->nextLoadReg = instr->rt;
+    st->nextLoadValue = nextLoadValue;
+    return TRUE;
+}
+
+static bool DoMfhi(Machine *m, Instruction *instr, ExecState *st) {
+    m->registers[instr->rd] = m->registers[HiReg];
+    return TRUE;
+}
+
+static bool DoMflo(Machine *m, Instruction *instr, ExecState *st) {
+    m->registers[instr->rd] = m->registers[LoReg];
+    return TRUE;
+}
+
+static bool DoMthi(Machine *m, Instruction *instr, ExecState *st) {
+    m->registers[HiReg] = m->registers[instr->rs];
+    return TRUE;
+}
+
+static bool DoMtlo(Machine *m, Instruction *instr, ExecState *st) {
+    m->registers[LoReg] = m->registers[instr->rs];
+    return TRUE;
+}
+
+static bool DoMult(Machine *m, Instruction *instr, ExecState *st) {
+    int *r = m->registers;
+    Mult(r[instr->rs], r[instr->rt], TRUE, &r[HiReg], &r[LoReg]);
+    return TRUE;
+}
+
+static bool DoMultu(Machine *m, Instruction *instr, ExecState *st) {
+    int *r = m->registers;
+    Mult(r[instr->rs], r[instr->rt], FALSE, &r[HiReg], &r[LoReg]);
+    return TRUE;
+}
+
+static bool DoNor(Machine *m, Instruction *instr, ExecState *st) {
+    int *r = m->registers;
+    r[instr->rd] = ~(r[instr->rs] | r[instr->rt]);
+    return TRUE;
+}
+
+static bool DoOr(Machine *m, Instruction *instr, ExecState *st) {
+    int *r = m->registers;
+    r[instr->rd] = r[instr->rs] | r[instr->rt];
+    return TRUE;
+}
+
+static bool DoOri(Machine *m, Instruction *instr, ExecState *st) {
+    m->registers[instr->rt] = m->registers[instr->rs] | (instr->extra & 0xffff);
+    return TRUE;
+}
+
+static bool DoSb(Machine *m, Instruction *instr, ExecState *st) {
+    int *r = m->registers;
+    return m->WriteMem((unsigned)(r[instr->rs] + instr->extra), 1,
+                       r[instr->rt]);
+}
+
+static bool DoSh(Machine *m, Instruction *instr, ExecState *st) {
+    int *r = m->registers;
+    return m->WriteMem((unsigned)(r[instr->rs] + instr->extra), 2,
+                       r[instr->rt]);
+}
+
+static bool DoSw(Machine *m, Instruction *instr, ExecState *st) {
+    int *r = m->registers;
+    return m->WriteMem((unsigned)(r[instr->rs] + instr->extra), 4,
+                       r[instr->rt]);
+}
+
+static bool DoSll(Machine *m, Instruction *instr, ExecState *st) {
+    m->registers[instr->rd] = m->registers[instr->rt] << instr->extra;
+    return TRUE;
+}
+
+static bool DoSllv(Machine *m, Instruction *instr, ExecState *st) {
+    int *r = m->registers;
+    r[instr->rd] = r[instr->rt] << (r[instr->rs] & 0x1f);
+    return TRUE;
+}
+
+static bool DoSlt(Machine *m, Instruction *instr, ExecState *st) {
+    int *r = m->registers;
+    r[instr->rd] = (r[instr->rs] < r[instr->rt]) ? 1 : 0;
+    return TRUE;
+}
+
+static bool DoSlti(Machine *m, Instruction *instr, ExecState *st) {
+    int *r = m->registers;
+    r[instr->rt] = (r[instr->rs] < instr->extra) ? 1 : 0;
+    return TRUE;
+}
+
+static bool DoSltiu(Machine *m, Instruction *instr, ExecState *st) {
+    unsigned int rs = m->registers[instr->rs];
+    unsigned int imm = instr->extra;
+    m->registers[instr->rt] = (rs < imm) ? 1 : 0;
+    return TRUE;
+}
+
+static bool DoSltu(Machine *m, Instruction *instr, ExecState *st) {
+    unsigned int rs = m->registers[instr->rs];
+    unsigned int rt = m->registers[instr->rt];
+    m->registers[instr->rd] = (rs < rt) ? 1 : 0;
+    return TRUE;
+}
+
+static bool DoSra(Machine *m, Instruction *instr, ExecState *st) {
+    m->registers[instr->rd] = m->registers[instr->rt] >> instr->extra;
+    return TRUE;
+}
+
+static bool DoSrav(Machine *m, Instruction *instr, ExecState *st) {
+    int *r = m->registers;
+    r[instr->rd] = r[instr->rt] >> (r[instr->rs] & 0x1f);
+    return TRUE;
+}
+
+static bool DoSrl(Machine *m, Instruction *instr, ExecState *st) {
+    unsigned tmp_unsigned = m->registers[instr->rt]; // zeroes shifted in
+    tmp_unsigned >>= instr->extra;
+    m->registers[instr->rd] = tmp_unsigned;
+    return TRUE;
+}
+
+static bool DoSrlv(Machine *m, Instruction *instr, ExecState *st) {
+    int *r = m->registers;
+    unsigned tmp_unsigned = r[instr->rt];
+    tmp_unsigned >>= (r[instr->rs] & 0x1f);
+    r[instr->rd] = tmp_unsigned;
+    return TRUE;
+}
+
+static bool DoSub(Machine *m, Instruction *instr, ExecState *st) {
+    int *r = m->registers;
+    int diff = r[instr->rs] - r[instr->rt];
+
+    if (((r[instr->rs] ^ r[instr->rt]) & SIGN_BIT) &&
+        ((r[instr->rs] ^ diff) & SIGN_BIT)) {
+        m->RaiseException(OverflowException, 0);
+        return FALSE;
+    }
+    r[instr->rd] = diff;
+    return TRUE;
+}
+
+static bool DoSubu(Machine *m, Instruction *instr, ExecState *st) {
+    int *r = m->registers;
+    r[instr->rd] = r[instr->rs] - r[instr->rt];
+    return TRUE;
+}
+
+static bool DoSwl(Machine *m, Instruction *instr, ExecState *st) {
+    int *r = m->registers;
+    int tmp = r[instr->rs] + instr->extra;
+    int value;
+
+    // Same restriction as in OneInstruction.
+    ASSERT((tmp & 0x3) == 0);
+
+    if (!m->ReadMem((tmp & ~0x3), 4, &value))
+        return FALSE;
+    switch (tmp & 0x3) {
+    case 0:
+        value = r[instr->rt];
+        break;
+    case 1:
+        value = (value & 0xff000000) | ((r[instr->rt] >> 8) & 0xffffff);
+        break;
+    case 2:
+        value = (value & 0xffff0000) | ((r[instr->rt] >> 16) & 0xffff);
+        break;
+    case 3:
+        value = (value & 0xffffff00) | ((r[instr->rt] >> 24) & 0xff);
+        break;
+    }
+    return m->WriteMem((tmp & ~0x3), 4, value);
+}
+
+static bool DoSwr(Machine *m, Instruction *instr, ExecState *st) {
+    int *r = m->registers;
+    int tmp = r[instr->rs] + instr->extra;
+    int value;
+
+    // Same restriction as in OneInstruction.
+    ASSERT((tmp & 0x3) == 0);
+
+    if (!m->ReadMem((tmp & ~0x3), 4, &value))
+        return FALSE;
+    switch (tmp & 0x3) {
+    case 0:
+        value = (value & 0xffffff) | (r[instr->rt] << 24);
+        break;
+    case 1:
+        value = (value & 0xffff) | (r[instr->rt] << 16);
+        break;
+    case 2:
+        value = (value & 0xff) | (r[instr->rt] << 8);
+        break;
+    case 3:
+        value = r[instr->rt];
+        break;
+    }
+    return m->WriteMem((tmp & ~0x3), 4, value);
+}
+
+static bool DoSyscall(Machine *m, Instruction *instr, ExecState *st) {
+    m->RaiseException(SyscallException, 0);
+    return FALSE;
+}
+
+static bool DoXor(Machine *m, Instruction *instr, ExecState *st) {
+    int *r = m->registers;
+    r[instr->rd] = r[instr->rs] ^ r[instr->rt];
+    return TRUE;
+}
+
+static bool DoXori(Machine *m, Instruction *instr, ExecState *st) {
+    m->registers[instr->rt] = m->registers[instr->rs] ^ (instr->extra & 0xffff);
+    return TRUE;
+}
+
+static bool DoIllegal(Machine *m, Instruction *instr, ExecState *st) {
+    m->RaiseException(IllegalInstrException, 0);
+    return FALSE;
+}
+
+//----------------------------------------------------------------------
+// HandlerFor
+//      Return the block handler for an opcode, or NULL if the opcode is
+//      left to the interpreter (which will stop on it).
+//----------------------------------------------------------------------
+
+static InstrHandler HandlerFor(int opCode) {
+    switch (opCode) {
+    case OP_ADD:
+        return DoAdd;
+    case OP_ADDI:
+        return DoAddi;
+    case OP_ADDIU:
+        return DoAddiu;
+    case OP_ADDU:
+        return DoAddu;
+    case OP_AND:
+        return DoAnd;
+    case OP_ANDI:
+        return DoAndi;
+    case OP_BEQ:
+        return DoBeq;
+    case OP_BGEZ:
+        return DoBgez;
+    case OP_BGEZAL:
+        return DoBgezal;
+    case OP_BGTZ:
+        return DoBgtz;
+    case OP_BLEZ:
+        return DoBlez;
+    case OP_BLTZ:
+        return DoBltz;
+    case OP_BLTZAL:
+        return DoBltzal;
+    case OP_BNE:
+        return DoBne;
+    case OP_DIV:
+        return DoDiv;
+    case OP_DIVU:
+        return DoDivu;
+    case OP_J:
+        return DoJ;
+    case OP_JAL:
+        return DoJal;
+    case OP_JALR:
+        return DoJalr;
+    case OP_JR:
+        return DoJr;
+    case OP_LB:
+    case OP_LBU:
+        return DoLb;
+    case OP_LH:
+    case OP_LHU:
+        return DoLh;
+    case OP_LUI:
+        return DoLui;
+    case OP_LW:
+        return DoLw;
+    case OP_LWL:
+        return DoLwl;
+    case OP_LWR:
+        return DoLwr;
+    case OP_MFHI:
+        return DoMfhi;
+    case OP_MFLO:
+        return DoMflo;
+    case OP_MTHI:
+        return DoMthi;
+    case OP_MTLO:
+        return DoMtlo;
+    case OP_MULT:
+        return DoMult;
+    case OP_MULTU:
+        return DoMultu;
+    case OP_NOR:
+        return DoNor;
+    case OP_OR:
+        return DoOr;
+    case OP_ORI:
+        return DoOri;
+    case OP_SB:
+        return DoSb;
+    case OP_SH:
+        return DoSh;
+    case OP_SLL:
+        return DoSll;
+    case OP_SLLV:
+        return DoSllv;
+    case OP_SLT:
+        return DoSlt;
+    case OP_SLTI:
+        return DoSlti;
+    case OP_SLTIU:
+        return DoSltiu;
+    case OP_SLTU:
+        return DoSltu;
+    case OP_SRA:
+        return DoSra;
+    case OP_SRAV:
+        return DoSrav;
+    case OP_SRL:
+        return DoSrl;
+    case OP_SRLV:
+        return DoSrlv;
+    case OP_SUB:
+        return DoSub;
+    case OP_SUBU:
+        return DoSubu;
+    case OP_SW:
+        return DoSw;
+    case OP_SWL:
+        return DoSwl;
+    case OP_SWR:
+        return DoSwr;
+    case OP_SYSCALL:
+        return DoSyscall;
+    case OP_XOR:
+        return DoXor;
+    case OP_XORI:
+        return DoXori;
+    case OP_RES:
+    case OP_UNIMP:
+        return DoIllegal;
+    default:
+        return NULL;
+    }
+}
+
+//----------------------------------------------------------------------
+// HasDelaySlot
+//      Return TRUE if the opcode is a branch or a jump, whose following
+//      instruction (the delay slot) is the last one of the block.
+//----------------------------------------------------------------------
+
+static bool HasDelaySlot(int opCode) {
+    switch (opCode) {
+    case OP_BEQ:
+    case OP_BGEZ:
+    case OP_BGEZAL:
+    case OP_BGTZ:
+    case OP_BLEZ:
+    case OP_BLTZ:
+    case OP_BLTZAL:
+    case OP_BNE:
+    case OP_J:
+    case OP_JAL:
+    case OP_JALR:
+    case OP_JR:
+        return TRUE;
+    default:
+        return FALSE;
+    }
+}
+
+//----------------------------------------------------------------------
+// Machine::BuildBlock
+//      Prepare the basic block whose first instruction is at physical
+//      address "physAddr".  A block never leaves its physical page, so
+//      one translation of its first PC covers all of it.
+//
+// Returns:
+//      NULL if the first instruction has no handler.
+//----------------------------------------------------------------------
+
+BasicBlock *Machine::BuildBlock(int physAddr) {
+    BasicBlock *block = new BasicBlock;
+    int frame = physAddr / PageSize;
+    int end = (frame + 1) * PageSize;
+    bool delaySlot = FALSE;
+
+    block->frame = frame;
+    block->generation = frameGeneration[frame];
+    block->length = 0;
+    for (int addr = physAddr; addr < end; addr += 4) {
+        Instruction *instr = &decodedInstrs[addr >> 2];
+        BlockOp *op = &block->ops[block->length];
+
+        if (instr->opCode == NotDecoded) {
+            instr->value = WordToHost(*(unsigned int *)&mainMemory[addr]);
+            instr->Decode();
+        }
+        op->handler = HandlerFor(instr->opCode);
+        if (op->handler == NULL)
+            break;
+        op->instr = *instr;
+        block->length++;
+        if (delaySlot || op->handler == DoSyscall || op->handler == DoIllegal)
+            break;
+        delaySlot = HasDelaySlot(instr->opCode);
+    }
+    if (block->length == 0) {
+        delete block;
+        return NULL;
+    }
+    return block;
+}
+
+//----------------------------------------------------------------------
+// Machine::FreeBlocks
+//      Delete every block in the block cache.
+//----------------------------------------------------------------------
+
+void Machine::FreeBlocks() {
+    for (int i = 0; i < NumInstrSlots; i++) {
+        delete blocks[i];
+        blocks[i] = NULL;
+    }
+}
+
+//----------------------------------------------------------------------
+// Machine::RunBlock
+//      Execute the basic block starting at PC, with the same effect
+//      on registers, memory and simulated time as calling
+//      OneInstruction and interrupt->OneTick for each instruction.
+//
+//      Simulated time: as long as no interrupt is due, OneTick would
+//      only add UserTick to the tick counters, so we do just that.  The
+//      tick that reaches the next pending interrupt goes through
+//      OneTick, and the block stops there, since the handler may
+//      switch to another thread.
+//
+//      The block also stops after an exception (the kernel has run and
+//      may have changed anything), or after a store that has retired
+//      the block (self-modifying code).
+//
+//      We start a block only when NextPC follows PC: if we are in the
+//      middle of a branch delay slot (e.g. a thread switched out right
+//      after a branch), the interpreter runs that one instruction.
+//----------------------------------------------------------------------
+
+void Machine::RunBlock() {
+    ExceptionType exception;
+    int physAddr;
+    BasicBlock *block;
+    long long due;
+
+    if (registers[NextPCReg] != registers[PCReg] + 4) {
+        OneInstruction();
+        interrupt->OneTick();
+        return;
+    }
+
+    exception = Translate(registers[PCReg], &physAddr, 4, FALSE);
+    if (exception != NoException) {
+        RaiseException(exception, registers[PCReg]);
+        interrupt->OneTick();
+        return;
+    }
+
+    block = blocks[physAddr >> 2];
+    if ((block == NULL) ||
+        (block->generation != frameGeneration[block->frame])) {
+        delete block;
+        block = blocks[physAddr >> 2] = BuildBlock(physAddr);
+        if (block == NULL) { // the interpreter stops on it
+            OneInstruction();
+            interrupt->OneTick();
+            return;
+        }
+    }
+
+    due = interrupt->NextDueTime();
+    for (BlockOp *op = block->ops; op < block->ops + block->length; op++) {
+        ExecState st;
+
+        st.pcAfter = registers[NextPCReg] + 4;
+        st.nextLoadReg = 0;
+        st.nextLoadValue = 0;
+        if (profile != NULL)
+            profile->CountInstruction(registers[PCReg], op->instr.opCode);
+        if (!(*op->handler)(this, &op->instr, &st)) {
+            interrupt->OneTick(); // as Run does after an exception
+            return;
+        }
+        if ((profile != NULL) && ((op->instr.opCode == OP_JAL) ||
+                                  (op->instr.opCode == OP_JALR)))
+            profile->CountCall(registers[PCReg], st.pcAfter);
+
+        DelayedLoad(st.nextLoadReg, st.nextLoadValue);
+        registers[PrevPCReg] = registers[PCReg];
+        registers[PCReg] = registers[NextPCReg];
+        registers[NextPCReg] = st.pcAfter;
+
+        if (stats->totalTicks + UserTick >= due) {
+            interrupt->OneTick();
+            return;
+        }
+        stats->totalTicks += UserTick;
+        stats->userTicks += UserTick;
+        interrupt->TickNotDue();
+
+        if (block->generation != frameGeneration[block->frame])
+            return;
+    }
+}
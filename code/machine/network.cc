@@ -54,9 +54,11 @@ Network::Network(NetworkAddress addr, double reliability,
     // start polling for incoming packets
     interrupt->Schedule(NetworkReadPoll, (int)this, NetworkTime,
                         NetworkRecvInt);
+    interrupt->WatchInput(sock);
 }
 
 Network::~Network() {
+    interrupt->IgnoreInput(sock);
     CloseSocket(sock);
     DeAssignNameToSocket(sockName);
 }
@@ -75,14 +77,13 @@ void Network::CheckPktAvail() {
         return;
 
     // otherwise, read packet in
-    char *buffer = new char[MaxWireSize];
+    char buffer[MaxWireSize];
     ReadFromSocket(sock, buffer, MaxWireSize);
 
     // divide packet into header and data
     inHdr = *(PacketHeader *)buffer;
     ASSERT((inHdr.to == ident) && (inHdr.length <= MaxPacketSize));
     bcopy(buffer + sizeof(PacketHeader), inbox, inHdr.length);
-    delete[] buffer;
 
     DEBUG('n', "Network received packet from %d, length %d...\n",
           (int)inHdr.from, inHdr.length);
@@ -122,11 +123,10 @@ void Network::Send(PacketHeader hdr, char *data) {
     }
 
     // concatenate hdr and data into a single buffer, and send it out
-    char *buffer = new char[MaxWireSize];
+    char buffer[MaxWireSize];
     *(PacketHeader *)buffer = hdr;
     bcopy(data, buffer + sizeof(PacketHeader), hdr.length);
     SendToSocket(sock, buffer, MaxWireSize, toName);
-    delete[] buffer;
 }
 
 // read a packet, if one is buffered
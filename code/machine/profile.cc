@@ -0,0 +1,339 @@
+// profile.cc
+//      Routines to record and report a profile of the user programs run
+//      by the machine simulation.  See profile.h.
+
+#include "copyright.h"
+#include "profile.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define HotSpots 20 // instructions listed in the report
+
+//----------------------------------------------------------------------
+// CompareSymbols
+//      Order symbols by address, for qsort.
+//----------------------------------------------------------------------
+
+static int CompareSymbols(const void *a, const void *b) {
+    return ((ProfileSymbol *)a)->address - ((ProfileSymbol *)b)->address;
+}
+
+//----------------------------------------------------------------------
+// Profile::Profile
+//      Initialize an empty profile, and read the addresses of the user
+//      functions.  Only text symbols ("T" or "t") are kept.
+//
+//      "symbolFile" is the output of "nm" on the user program, or NULL
+//----------------------------------------------------------------------
+
+Profile::Profile(const char *symbolFile) {
+    int i;
+
+    pcCounts = new long long[MemorySize / 4];
+    for (i = 0; i < MemorySize / 4; i++)
+        pcCounts[i] = 0;
+    for (i = 0; i < ProfiledOpcodes; i++)
+        opCounts[i] = 0;
+    for (i = 0; i < NumPhysPages; i++)
+        pageReads[i] = pageWrites[i] = 0;
+    for (i = 0; i < ProfiledSyscalls; i++)
+        syscallCounts[i] = 0;
+    otherInstructions = otherAccesses = lostCalls = 0;
+    arcs = new CallArc[MaxCallArcs];
+    for (i = 0; i < MaxCallArcs; i++)
+        arcs[i].from = -1;
+
+    symbols = NULL;
+    numSymbols = 0;
+    if (symbolFile == NULL)
+        return;
+
+    FILE *file = fopen(symbolFile, "r");
+    char line[256], name[256], type;
+    unsigned int address;
+    int size = 64;
+
+    if (file == NULL) {
+        printf("Unable to open symbol file %s\n", symbolFile);
+        return;
+    }
+    symbols = new ProfileSymbol[size];
+    while (fgets(line, sizeof(line), file) != NULL) {
+        if ((sscanf(line, "%x %c %255s", &address, &type, name) != 3) ||
+            ((type != 'T') && (type != 't')))
+            continue;
+        if (numSymbols == size) { // full: double the table
+            ProfileSymbol *bigger = new ProfileSymbol[2 * size];
+            for (i = 0; i < numSymbols; i++)
+                bigger[i] = symbols[i];
+            delete[] symbols;
+            symbols = bigger;
+            size *= 2;
+        }
+        symbols[numSymbols].address = address;
+        symbols[numSymbols].name = strdup(name);
+        numSymbols++;
+    }
+    fclose(file);
+    qsort(symbols, numSymbols, sizeof(ProfileSymbol), CompareSymbols);
+    DEBUG('m', "Profile: %d functions in %s\n", numSymbols, symbolFile);
+}
+
+//----------------------------------------------------------------------
+// Profile::~Profile
+//      De-allocate the profile.
+//----------------------------------------------------------------------
+
+Profile::~Profile() {
+    delete[] pcCounts;
+    delete[] arcs;
+    for (int i = 0; i < numSymbols; i++)
+        free(symbols[i].name);
+    delete[] symbols;
+}
+
+//----------------------------------------------------------------------
+// Profile::CountCall
+//      Count a call (jal or jalr) from one address to another, in a
+//      hash table with linear probing.  Once the table is full, calls
+//      along new arcs are only counted as lost.
+//
+//      "from" -- the address of the call instruction
+//      "to" -- the address called
+//----------------------------------------------------------------------
+
+void Profile::CountCall(int from, int to) {
+    unsigned int slot = ((unsigned)from / 4 * 31 + (unsigned)to / 4) %
+                        MaxCallArcs;
+
+    for (int probes = 0; probes < MaxCallArcs; probes++) {
+        CallArc *arc = &arcs[slot];
+
+        if ((arc->from == from) && (arc->to == to)) {
+            arc->count++;
+            return;
+        }
+        if (arc->from == -1) {
+            arc->from = from;
+            arc->to = to;
+            arc->count = 1;
+            return;
+        }
+        slot = (slot + 1) % MaxCallArcs;
+    }
+    lostCalls++;
+}
+
+//----------------------------------------------------------------------
+// Profile::FindSymbol
+//      Binary search for the function holding an address: the last one
+//      starting at or before it.
+//
+// Returns:
+//      The index of the function in "symbols", or -1.
+//----------------------------------------------------------------------
+
+int Profile::FindSymbol(int address) {
+    int low = 0, high = numSymbols - 1, found = -1;
+
+    while (low <= high) {
+        int middle = (low + high) / 2;
+
+        if (symbols[middle].address <= address) {
+            found = middle;
+            low = middle + 1;
+        } else
+            high = middle - 1;
+    }
+    return found;
+}
+
+//----------------------------------------------------------------------
+// Profile::PrintAddress
+//      Print an address as "function+offset", or in hex if it is not in
+//      any known function.
+//----------------------------------------------------------------------
+
+void Profile::PrintAddress(int address) {
+    int i = FindSymbol(address);
+
+    if (i < 0)
+        printf("0x%x", address);
+    else if (address == symbols[i].address)
+        printf("%s", symbols[i].name);
+    else
+        printf("%s+0x%x", symbols[i].name, address - symbols[i].address);
+}
+
+//----------------------------------------------------------------------
+// Profile::PrintFlat
+//      Print the instructions executed in each function, most first.
+//----------------------------------------------------------------------
+
+void Profile::PrintFlat(long long total) {
+    long long *counts = new long long[numSymbols + 1]; // last: unknown
+    long long cumulative = 0;
+    int i, best;
+
+    for (i = 0; i <= numSymbols; i++)
+        counts[i] = 0;
+    for (i = 0; i < MemorySize / 4; i++)
+        if (pcCounts[i] != 0) {
+            int which = FindSymbol(i * 4);
+            counts[(which < 0) ? numSymbols : which] += pcCounts[i];
+        }
+
+    printf("Flat profile:\n");
+    printf("  %%time cumul%%  instructions  function\n");
+    for (;;) {
+        best = -1;
+        for (i = 0; i <= numSymbols; i++)
+            if ((counts[i] != 0) && ((best < 0) || (counts[i] > counts[best])))
+                best = i;
+        if (best < 0)
+            break;
+        cumulative += counts[best];
+        printf("  %5.1f %6.1f  %12lld  %s\n", 100.0 * counts[best] / total,
+               100.0 * cumulative / total, counts[best],
+               (best == numSymbols) ? "<unknown>" : symbols[best].name);
+        counts[best] = 0;
+    }
+    delete[] counts;
+}
+
+//----------------------------------------------------------------------
+// Profile::PrintHotSpots
+//      Print the HotSpots instructions executed most often.
+//----------------------------------------------------------------------
+
+void Profile::PrintHotSpots(long long total) {
+    long long shown = 0x7fffffffffffffffLL; // count of the last one shown
+    int last = -1;                          // index of the last one shown
+    int i, best, n;
+
+    printf("Hot spots:\n");
+    printf("  address     count  %%time  location\n");
+    for (n = 0; n < HotSpots; n++) {
+        // the next one is the largest count below the last, or equal to
+        // it but further in memory
+        best = -1;
+        for (i = 0; i < MemorySize / 4; i++)
+            if ((pcCounts[i] != 0) &&
+                ((pcCounts[i] < shown) ||
+                 ((pcCounts[i] == shown) && (i > last))) &&
+                ((best < 0) || (pcCounts[i] > pcCounts[best])))
+                best = i;
+        if (best < 0)
+            break;
+        printf("  0x%06x %9lld %6.1f  ", best * 4, pcCounts[best],
+               100.0 * pcCounts[best] / total);
+        PrintAddress(best * 4);
+        printf("\n");
+        shown = pcCounts[best];
+        last = best;
+    }
+}
+
+//----------------------------------------------------------------------
+// Profile::PrintCalls
+//      Print the number of calls between functions (or between call
+//      sites and targets, without symbols), most frequent first.
+//----------------------------------------------------------------------
+
+void Profile::PrintCalls() {
+    CallArc *merged = new CallArc[MaxCallArcs];
+    int numMerged = 0;
+    int i, j, best;
+
+    for (i = 0; i < MaxCallArcs; i++) {
+        int from, to;
+
+        if (arcs[i].from == -1)
+            continue;
+        from = arcs[i].from;
+        to = arcs[i].to;
+        if (numSymbols > 0) { // merge the arcs between two functions
+            from = FindSymbol(from);
+            to = FindSymbol(to);
+            from = (from < 0) ? arcs[i].from : symbols[from].address;
+            to = (to < 0) ? arcs[i].to : symbols[to].address;
+        }
+        for (j = 0; j < numMerged; j++)
+            if ((merged[j].from == from) && (merged[j].to == to))
+                break;
+        if (j == numMerged) {
+            merged[numMerged].from = from;
+            merged[numMerged].to = to;
+            merged[numMerged].count = 0;
+            numMerged++;
+        }
+        merged[j].count += arcs[i].count;
+    }
+
+    printf("Calls:\n");
+    for (;;) {
+        best = -1;
+        for (i = 0; i < numMerged; i++)
+            if ((merged[i].count != 0) &&
+                ((best < 0) || (merged[i].count > merged[best].count)))
+                best = i;
+        if (best < 0)
+            break;
+        printf("  %9lld  ", merged[best].count);
+        PrintAddress(merged[best].from);
+        printf(" -> ");
+        PrintAddress(merged[best].to);
+        printf("\n");
+        merged[best].count = 0;
+    }
+    if (lostCalls > 0)
+        printf("  %9lld  calls along arcs that did not fit\n", lostCalls);
+    delete[] merged;
+}
+
+//----------------------------------------------------------------------
+// Profile::Print
+//      Print the report: where the instructions were executed, which
+//      opcodes, which pages were accessed, the system calls, and the
+//      calls between functions.
+//----------------------------------------------------------------------
+
+void Profile::Print() {
+    long long total = otherInstructions;
+    int i;
+
+    for (i = 0; i < MemorySize / 4; i++)
+        total += pcCounts[i];
+    printf("\nProfile: %lld user instructions\n", total);
+    if (total == 0)
+        return;
+
+    if (numSymbols > 0)
+        PrintFlat(total);
+    PrintHotSpots(total);
+    if (otherInstructions > 0)
+        printf("  %lld instructions beyond physical memory size\n",
+               otherInstructions);
+
+    printf("Opcodes:\n");
+    for (i = 0; i < ProfiledOpcodes; i++)
+        if (opCounts[i] != 0)
+            printf("  %-8s %12lld %6.1f%%\n", OpcodeName(i), opCounts[i],
+                   100.0 * opCounts[i] / total);
+
+    printf("Memory accesses (virtual page: loads, stores):\n");
+    for (i = 0; i < NumPhysPages; i++)
+        if ((pageReads[i] != 0) || (pageWrites[i] != 0))
+            printf("  %4d: %12lld %12lld\n", i, pageReads[i], pageWrites[i]);
+    if (otherAccesses > 0)
+        printf("  %lld accesses beyond physical memory size\n",
+               otherAccesses);
+
+    printf("System calls:\n");
+    for (i = 0; i < ProfiledSyscalls; i++)
+        if (syscallCounts[i] != 0)
+            printf("  %4d: %12lld\n", i, syscallCounts[i]);
+
+    PrintCalls();
+}
@@ -0,0 +1,112 @@
+// profile.h
+//      Data structures for profiling the execution of user programs.
+//
+//      When Nachos is started with "-prof", the machine simulation
+//      counts, exactly, how many times each user instruction (by virtual
+//      address) and each opcode was executed, the loads and stores to
+//      each virtual page (including those the kernel makes through
+//      ReadMem and WriteMem, to copy system call arguments), the system
+//      calls made, and the calls from each call site to each target.
+//      The report is printed when Nachos halts.
+//
+//      User programs carry no symbols once converted to NOFF, so the
+//      report can be keyed to function names taken from a symbol file
+//      in the format printed by "nm" on the COFF executable:
+//
+//              mips-nm -n matmult.coff > matmult.sym
+//              nachos -prof matmult.sym -x matmult
+//
+//      Counts are by virtual address, summed over all the address spaces
+//      that ran: the report is meant for one program at a time.
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "copyright.h"
+#include "machine.h"
+
+#define ProfiledOpcodes 64   // opcodes counted (see MaxOpcode)
+#define ProfiledSyscalls 64  // system call codes counted (see syscall.h)
+#define MaxCallArcs 1024     // distinct (call site, target) pairs kept
+
+// A user function, from the symbol file.
+class ProfileSymbol {
+  public:
+    int address; // first instruction
+    char *name;
+};
+
+// The number of times a call site called a target.
+class CallArc {
+  public:
+    int from;        // address of the jal or jalr, -1 if the slot is free
+    int to;          // address called
+    long long count;
+};
+
+// The following class defines the counters kept for the profile.  The
+// Count routines are called by the simulator for every instruction, so
+// they are inline, and do nothing but bump a counter.
+
+class Profile {
+  public:
+    Profile(const char *symbolFile); // Start an empty profile; read the
+    // function names from "symbolFile"
+    // (nm format) unless it is NULL
+    ~Profile();
+
+    void CountInstruction(int pc, int opCode) {
+        if ((unsigned)pc < (unsigned)MemorySize)
+            pcCounts[(unsigned)pc / 4]++;
+        else
+            otherInstructions++;
+        opCounts[opCode]++;
+    }
+    // Count the instruction at "pc"
+
+    void CountAccess(int addr, bool writing) {
+        if ((unsigned)addr >= (unsigned)MemorySize)
+            otherAccesses++;
+        else if (writing)
+            pageWrites[(unsigned)addr / PageSize]++;
+        else
+            pageReads[(unsigned)addr / PageSize]++;
+    }
+    // Count a load or store at "addr"
+
+    void CountSyscall(int type) {
+        if ((unsigned)type < ProfiledSyscalls)
+            syscallCounts[type]++;
+    }
+    // Count a system call with code "type"
+
+    void CountCall(int from, int to); // Count a call from "from" to "to"
+
+    void Print(); // Print the profile report
+
+  private:
+    int FindSymbol(int address); // Index of the function holding
+    // "address", -1 if none
+    void PrintAddress(int address); // As function+offset, if possible
+    void PrintFlat(long long total);  // Sections of the report
+    void PrintHotSpots(long long total);
+    void PrintCalls();
+
+    long long *pcCounts; // indexed by virtual address / 4
+    long long otherInstructions; // at addresses beyond MemorySize
+    long long opCounts[ProfiledOpcodes];
+    long long pageReads[NumPhysPages]; // indexed by virtual page
+    long long pageWrites[NumPhysPages];
+    long long otherAccesses;
+    long long syscallCounts[ProfiledSyscalls];
+    CallArc *arcs; // hash table of MaxCallArcs entries
+    long long lostCalls; // not counted, because "arcs" was full
+
+    ProfileSymbol *symbols; // sorted by address
+    int numSymbols;
+};
+
+extern const char *OpcodeName(int opCode); // Mnemonic of an opcode
+// (defined in mipssim.cc)
+
+#endif // PROFILE_H
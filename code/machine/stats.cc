@@ -9,8 +9,13 @@
 
 #include "stats.h"
 #include "copyright.h"
+#include "lockstats.h"
+#include "objectpool.h"
+#include "stackpool.h"
 #include "utility.h"
 
+ObjectPool *ObjectPool::firstPool = NULL; // each pool adds itself
+
 //----------------------------------------------------------------------
 // Statistics::Statistics
 //      Initialize performance metrics to zero, at system startup.
@@ -21,6 +26,12 @@ Statistics::Statistics() {
     numDiskReads = numDiskWrites = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
+    numEvictions = numSwapReads = numSwapWrites = numCopiesOnWrite = 0;
+    numSharedCodePages = 0;
+    numTLBHits = 0;
+    numTLBMisses = numTLBFlushes = 0;
+    numSameSpaceSwitches = numCrossSpaceSwitches = 0;
+    numSlices = numYields = numPreemptions = 0;
 }
 
 //----------------------------------------------------------------------
@@ -40,7 +51,25 @@ void Statistics::Print() {
     printf("Disk I/O: reads %d, writes %d\n", numDiskReads, numDiskWrites);
     printf("Console I/O: reads %d, writes %d\n", numConsoleCharsRead,
            numConsoleCharsWritten);
-    printf("Paging: faults %d\n", numPageFaults);
+    printf("Paging: faults %d, evictions %d, writebacks %d, swap reads %d, "
+           "copies on write %d, shared code pages %d\n",
+           numPageFaults, numEvictions, numSwapWrites, numSwapReads,
+           numCopiesOnWrite, numSharedCodePages);
+#ifdef USE_TLB
+    long long lookups = numTLBHits + numTLBMisses;
+    printf("TLB: hits %lld, misses %d (%.2f%%), flushes %d\n", numTLBHits,
+           numTLBMisses, (lookups > 0) ? 100.0 * numTLBMisses / lookups : 0.0,
+           numTLBFlushes);
+#endif
     printf("Network I/O: packets received %d, sent %d\n", numPacketsRecvd,
            numPacketsSent);
+    printf("Context switches: same address space %d, other %d\n",
+           numSameSpaceSwitches, numCrossSpaceSwitches);
+    printf("Time slices: %d, ended by yield or block %d, by preemption %d\n",
+           numSlices, numYields, numPreemptions);
+    for (ObjectPool *pool = ObjectPool::firstPool; pool != NULL;
+         pool = pool->nextPool)
+        pool->Print();
+    stackPool.Print();
+    LockStats::PrintAll();
 }
@@ -42,8 +42,28 @@ class Statistics {
     int numConsoleCharsRead;    // number of characters read from the keyboard
     int numConsoleCharsWritten; // number of characters written to the display
     int numPageFaults;          // number of virtual memory page faults
+    int numEvictions;           // pages evicted to make room
+    int numSwapReads;           // pages read back from the swap file
+    int numSwapWrites;          // pages written to the swap file
+    int numCopiesOnWrite;       // pages shared by a fork, then copied
+                                // when written
+    int numSharedCodePages;     // code pages mapped from the text cache,
+                                // rather than read from the executable
+    long long numTLBHits;       // translations found in the TLB
+    int numTLBMisses;           // ... and not found, so refilled by
+                                // the kernel
+    int numTLBFlushes;          // times the TLB was emptied, because
+                                // another address space was loaded
+                                // or a page was evicted
     int numPacketsSent;         // number of packets sent over the network
     int numPacketsRecvd;        // number of packets received over the network
+    int numSameSpaceSwitches;   // context switches to a user thread whose
+                                // page table was already loaded
+    int numCrossSpaceSwitches;  // ... and whose page table had to be
+                                // loaded
+    int numSlices;              // times a thread was given the CPU
+    int numYields;              // times a thread gave it up on its own
+    int numPreemptions;         // times an interrupt took it from a thread
 
     Statistics(); // initialize everything to zero
 
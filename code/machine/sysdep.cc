@@ -28,6 +28,7 @@
 extern "C" {
 #include <errno.h> // modif norme ansi
 #include <fcntl.h>
+#include <poll.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -135,6 +136,32 @@ bool PollFile(int fd) {
     return TRUE;
 }
 
+//----------------------------------------------------------------------
+// WaitForInput
+//      Block the host process until one of the open files or sockets
+//      has characters that can be read.  Used when Nachos has nothing
+//      to do but wait for input, instead of polling in a loop.
+//
+//      "fds" -- the file descriptors to wait on
+//      "numFds" -- how many there are
+//----------------------------------------------------------------------
+
+void WaitForInput(int *fds, int numFds) {
+    struct pollfd *pfds = new struct pollfd[numFds];
+    int retVal;
+
+    for (int i = 0; i < numFds; i++) {
+        pfds[i].fd = fds[i];
+        pfds[i].events = POLLIN;
+        pfds[i].revents = 0;
+    }
+    do {
+        retVal = poll(pfds, numFds, -1); // no timeout
+    } while ((retVal < 0) && (errno == EINTR));
+    delete[] pfds;
+    ASSERT(retVal > 0);
+}
+
 //----------------------------------------------------------------------
 // OpenForWrite
 //      Open a file for writing.  Create it if it doesn't exist; truncate it
@@ -235,6 +262,19 @@ void Close(int fd) {
 
 bool Unlink(const char *name) { return unlink(name); }
 
+//----------------------------------------------------------------------
+// FileNumber
+//      Return a number telling an open file apart from the other files
+//      of the host (its inode number), whatever name it was opened by.
+//----------------------------------------------------------------------
+
+int FileNumber(int fd) {
+    struct stat status;
+    int retVal = fstat(fd, &status);
+    ASSERT(retVal == 0);
+    return (int)status.st_ino;
+}
+
 //----------------------------------------------------------------------
 // OpenSocket
 //      Open an interprocess communication (IPC) connection.  For now,
@@ -432,3 +472,51 @@ void DeallocBoundedArray(char *ptr, int size) {
     mprotect(ptr + size, pgSize, PROT_READ | PROT_WRITE | PROT_EXEC);
     delete[] (ptr - pgSize);
 }
+
+//----------------------------------------------------------------------
+// ReserveBoundedArray
+//      Like AllocBoundedArray, but map the array (and its two boundary
+//      pages) directly from the host, without reserving swap space for
+//      it: the host only commits memory for the pages that are touched.
+//      Meant for large arrays that are mostly left untouched, such as
+//      thread execution stacks.
+//
+//      "size" -- amount of useful space needed (in bytes); rounded up to
+//              a multiple of the host page size, so that the upper
+//              boundary page is aligned
+//----------------------------------------------------------------------
+
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#ifndef MAP_NORESERVE
+#define MAP_NORESERVE 0 // not supported: commit it all, like new[] would
+#endif
+
+char *ReserveBoundedArray(int size) {
+    int pgSize = getpagesize();
+    char *ptr;
+
+    size = divRoundUp(size, pgSize) * pgSize;
+    ptr = (char *)mmap(NULL, pgSize * 2 + size, PROT_NONE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    ASSERT(ptr != (char *)MAP_FAILED);
+    mprotect(ptr + pgSize, size, PROT_READ | PROT_WRITE); // all but the
+    return ptr + pgSize;                                   // boundaries
+}
+
+//----------------------------------------------------------------------
+// ReleaseBoundedArray
+//      Give an array obtained from ReserveBoundedArray, boundary pages
+//      included, back to the host.
+//
+//      "ptr" -- the array to be released
+//      "size" -- amount of useful space in the array (in bytes)
+//----------------------------------------------------------------------
+
+void ReleaseBoundedArray(char *ptr, int size) {
+    int pgSize = getpagesize();
+
+    size = divRoundUp(size, pgSize) * pgSize;
+    munmap(ptr - pgSize, pgSize * 2 + size);
+}
@@ -17,6 +17,10 @@
 // If no characters in the file, return without waiting.
 extern bool PollFile(int fd);
 
+// Wait until at least one of the "numFds" files (or sockets) in "fds"
+// has characters to be read.
+extern void WaitForInput(int *fds, int numFds);
+
 // File operations: open/read/write/lseek/close, and check for error
 // For simulating the disk and the console devices.
 extern int OpenForWrite(const char *name);
@@ -28,6 +32,7 @@ extern void Lseek(int fd, int offset, int whence);
 extern int Tell(int fd);
 extern void Close(int fd);
 extern bool Unlink(const char *name);
+extern int FileNumber(int fd);
 
 // Interprocess communication operations, for simulating the network
 extern int OpenSocket();
@@ -56,6 +61,11 @@ extern int Random();
 extern char *AllocBoundedArray(int size);
 extern void DeallocBoundedArray(char *p, int size);
 
+// The same, with the pages of the array only committed by the host once
+// they are touched
+extern char *ReserveBoundedArray(int size);
+extern void ReleaseBoundedArray(char *p, int size);
+
 // Other C library routines that are used by Nachos.
 // These are assumed to be portable, so we don't include a wrapper.
 #include <stdio.h>  // for printf, fprintf
@@ -41,10 +41,15 @@ static void TimerHandler(int arg) {
 //      "callArg" is the parameter to be passed to the interrupt handler.
 //      "doRandom" -- if true, arrange for the interrupts to occur
 //              at random, instead of fixed, intervals.
+//      "ticks" -- the interval between interrupts, or their average
+//              interval if doRandom (usually TimerTicks)
 //----------------------------------------------------------------------
 
-Timer::Timer(VoidFunctionPtr timerHandler, int callArg, bool doRandom) {
+Timer::Timer(VoidFunctionPtr timerHandler, int callArg, bool doRandom,
+             int ticks) {
+    ASSERT(ticks > 0);
     randomize = doRandom;
+    interval = ticks;
     handler = timerHandler;
     arg = callArg;
 
@@ -76,7 +81,7 @@ void Timer::TimerExpired() {
 
 int Timer::TimeOfNextInterrupt() {
     if (randomize)
-        return 1 + (Random() % (TimerTicks * 2));
+        return 1 + (Random() % (interval * 2));
     else
-        return TimerTicks;
+        return interval;
 }
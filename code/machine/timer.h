@@ -26,9 +26,11 @@
 // The following class defines a hardware timer.
 class Timer {
   public:
-    Timer(VoidFunctionPtr timerHandler, int callArg, bool doRandom);
+    Timer(VoidFunctionPtr timerHandler, int callArg, bool doRandom,
+          int ticks);
     // Initialize the timer, to call the interrupt
-    // handler "timerHandler" every time slice.
+    // handler "timerHandler" every "ticks"
+    // (on average, if doRandom)
     ~Timer() {}
 
     // Internal routines to the timer emulation -- DO NOT call these
@@ -41,6 +43,7 @@ class Timer {
 
   private:
     bool randomize;          // set if we need to use a random timeout delay
+    int interval;            // (average) ticks between interrupts
     VoidFunctionPtr handler; // timer interrupt handler
     int arg;                 // argument to pass to interrupt handler
 };
@@ -32,6 +32,7 @@
 #include "addrspace.h"
 #include "copyright.h"
 #include "machine.h"
+#include "profile.h"
 #include "system.h"
 
 // Routines for converting Words and Short Words to and from the
@@ -68,13 +69,55 @@ unsigned short ShortToMachine(unsigned short shortword) {
     return ShortToHost(shortword);
 }
 
+//----------------------------------------------------------------------
+// Machine::LookupCache
+//      Look for an aligned virtual address in one of the translation
+//      caches, and store its physical address in "physAddr" on a hit.
+//
+//      With a TLB, a cached translation is still in the TLB (the kernel
+//      flushes the caches when it replaces an entry), so a hit is a TLB
+//      hit, and counts as one.
+//
+//      Returns FALSE if Translate has to be called (a miss, or an
+//      unaligned address, which Translate will report).
+//----------------------------------------------------------------------
+
+inline bool Machine::LookupCache(CachedTranslation *cache, int virtAddr,
+                                 int size, int *physAddr) {
+    unsigned int vpn = (unsigned)virtAddr / PageSize;
+    CachedTranslation *slot = &cache[vpn & (TranslationCacheSize - 1)];
+
+    if ((slot->virtualPage != (int)vpn) || (virtAddr & (size - 1)))
+        return FALSE;
+#ifdef USE_TLB
+    tlbLastUse[slot->tlbEntry] = ++tlbHits;
+    stats->numTLBHits++;
+#endif
+    *physAddr = slot->physBase + (unsigned)virtAddr % PageSize;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Machine::FlushTranslationCache
+//      Empty both translation caches.
+//----------------------------------------------------------------------
+
+void Machine::FlushTranslationCache() {
+    for (int i = 0; i < TranslationCacheSize; i++) {
+        readCache[i].virtualPage = -1;
+        writeCache[i].virtualPage = -1;
+    }
+}
+
 //----------------------------------------------------------------------
 // Machine::ReadMem
 //      Read "size" (1, 2, or 4) bytes of virtual memory at "addr" into
 //      the location pointed to by "value".
 //
 //      Returns FALSE if the translation step from virtual to physical memory
-//      failed.
+//      failed.  With DEMAND_PAGING or a TLB, a page fault (or TLB miss)
+//      taken on behalf of the kernel (copying system call arguments) is
+//      handled on the spot, so that the kernel need not retry.
 //
 //      "addr" -- the virtual address to read from
 //      "size" -- the number of bytes to read (1, 2, or 4)
@@ -87,25 +130,39 @@ bool Machine::ReadMem(int addr, int size, int *value) {
     int physicalAddress;
 
     DEBUG('a', "Reading VA 0x%x, size %d\n", addr, size);
+    if (profile != NULL)
+        profile->CountAccess(addr, FALSE);
 
-    exception = Translate(addr, &physicalAddress, size, FALSE);
-    if (exception != NoException) {
-        machine->RaiseException(exception, addr);
-        return FALSE;
+    if (!LookupCache(readCache, addr, size, &physicalAddress)) {
+        exception = Translate(addr, &physicalAddress, size, FALSE);
+#if defined(DEMAND_PAGING) || defined(USE_TLB)
+        if ((exception == PageFaultException) &&
+            (interrupt->getStatus() == SystemMode)) {
+            // the kernel itself touched a page of the user program that
+            // is not in memory, or not in the TLB: have it brought in,
+            // and try again
+            RaiseException(exception, addr);
+            exception = Translate(addr, &physicalAddress, size, FALSE);
+        }
+#endif
+        if (exception != NoException) {
+            RaiseException(exception, addr);
+            return FALSE;
+        }
     }
     switch (size) {
     case 1:
-        data = machine->mainMemory[physicalAddress];
+        data = mainMemory[physicalAddress];
         *value = data;
         break;
 
     case 2:
-        data = *(unsigned short *)&machine->mainMemory[physicalAddress];
+        data = *(unsigned short *)&mainMemory[physicalAddress];
         *value = ShortToHost(data);
         break;
 
     case 4:
-        data = *(unsigned int *)&machine->mainMemory[physicalAddress];
+        data = *(unsigned int *)&mainMemory[physicalAddress];
         *value = WordToHost(data);
         break;
 
@@ -123,7 +180,9 @@ bool Machine::ReadMem(int addr, int size, int *value) {
 //      virtual memory at location "addr".
 //
 //      Returns FALSE if the translation step from virtual to physical memory
-//      failed.
+//      failed.  As in ReadMem, faults taken on behalf of the kernel are
+//      handled on the spot -- including writes to pages shared copy on
+//      write by a fork.
 //
 //      "addr" -- the virtual address to write to
 //      "size" -- the number of bytes to be written (1, 2, or 4)
@@ -135,30 +194,58 @@ bool Machine::WriteMem(int addr, int size, int value) {
     int physicalAddress;
 
     DEBUG('a', "Writing VA 0x%x, size %d, value 0x%x\n", addr, size, value);
+    if (profile != NULL)
+        profile->CountAccess(addr, TRUE);
 
-    exception = Translate(addr, &physicalAddress, size, TRUE);
-    if (exception != NoException) {
-        machine->RaiseException(exception, addr);
-        return FALSE;
+    if (!LookupCache(writeCache, addr, size, &physicalAddress)) {
+        exception = Translate(addr, &physicalAddress, size, TRUE);
+#if defined(DEMAND_PAGING) || defined(USE_TLB)
+        if ((exception == PageFaultException) &&
+            (interrupt->getStatus() == SystemMode)) {
+            // the kernel itself touched a page of the user program that
+            // is not in memory, or not in the TLB: have it brought in,
+            // and try again
+            RaiseException(exception, addr);
+            exception = Translate(addr, &physicalAddress, size, TRUE);
+        }
+#endif
+        if ((exception == ReadOnlyException) &&
+            (interrupt->getStatus() == SystemMode)) {
+            // the kernel wrote to a page shared by a fork: have it
+            // copied, and try again
+            RaiseException(exception, addr);
+            exception = Translate(addr, &physicalAddress, size, TRUE);
+        }
+        if (exception != NoException) {
+            RaiseException(exception, addr);
+            return FALSE;
+        }
     }
     switch (size) {
     case 1:
-        machine->mainMemory[physicalAddress] = (unsigned char)(value & 0xff);
+        mainMemory[physicalAddress] = (unsigned char)(value & 0xff);
         break;
 
     case 2:
-        *(unsigned short *)&machine->mainMemory[physicalAddress] =
+        *(unsigned short *)&mainMemory[physicalAddress] =
             ShortToMachine((unsigned short)(value & 0xffff));
         break;
 
     case 4:
-        *(unsigned int *)&machine->mainMemory[physicalAddress] =
+        *(unsigned int *)&mainMemory[physicalAddress] =
             WordToMachine((unsigned int)value);
         break;
 
     default:
         ASSERT(FALSE);
     }
+    // if the word was decoded as code, force it to be decoded again, and
+    // retire any basic block built from its frame (every word of a block
+    // is decoded); stores to data leave the blocks of the frame alone
+    if (decodedInstrs[physicalAddress >> 2].opCode != NotDecoded) {
+        decodedInstrs[physicalAddress >> 2].opCode = NotDecoded;
+        frameGeneration[physicalAddress / PageSize]++;
+    }
 
     return TRUE;
 }
@@ -172,6 +259,9 @@ bool Machine::WriteMem(int addr, int size, int value) {
 //      address in "physAddr".  If there was an error, returns the type
 //      of the exception.
 //
+//      Successful translations are remembered in readCache (and in
+//      writeCache when "writing"); see FlushTranslationCache.
+//
 //      "virtAddr" -- the virtual address to translate
 //      "physAddr" -- the place to store the physical address
 //      "size" -- the amount of memory being read or written
@@ -180,10 +270,15 @@ bool Machine::WriteMem(int addr, int size, int value) {
 
 ExceptionType Machine::Translate(int virtAddr, int *physAddr, int size,
                                  bool writing) {
-    int i;
+    int i = -1; // the TLB entry used, if there is a TLB
     unsigned int vpn, offset;
     TranslationEntry *entry;
     unsigned int pageFrame;
+    CachedTranslation *slot;
+
+    if (LookupCache(writing ? writeCache : readCache, virtAddr, size,
+                    physAddr))
+        return NoException;
 
     DEBUG('a', "\tTranslate 0x%x, %s: ", virtAddr, writing ? "write" : "read");
 
@@ -215,17 +310,20 @@ ExceptionType Machine::Translate(int virtAddr, int *physAddr, int size,
         }
         entry = &pageTable[vpn];
     } else {
-        for (entry = NULL, i = 0; i < TLBSize; i++)
+        for (entry = NULL, i = 0; i < tlbSize; i++)
             if (tlb[i].valid && (tlb[i].virtualPage == vpn)) {
                 entry = &tlb[i]; // FOUND!
                 break;
             }
         if (entry == NULL) { // not found
             DEBUG('a', "*** no valid TLB entry found for this virtual page!\n");
+            stats->numTLBMisses++;
             return PageFaultException; // really, this is a TLB fault,
                                        // the page may be in memory,
                                        // but not in the TLB
         }
+        tlbLastUse[i] = ++tlbHits;
+        stats->numTLBHits++;
     }
 
     if (entry->readOnly && writing) { // trying to write to a read-only page
@@ -243,6 +341,15 @@ ExceptionType Machine::Translate(int virtAddr, int *physAddr, int size,
     entry->use = TRUE; // set the use, dirty bits
     if (writing)
         entry->dirty = TRUE;
+
+    // cache the translation, now that hits need not touch the entry
+    slot = &readCache[vpn & (TranslationCacheSize - 1)];
+    slot->virtualPage = vpn;
+    slot->physBase = pageFrame * PageSize;
+    slot->tlbEntry = i;
+    if (writing)
+        writeCache[vpn & (TranslationCacheSize - 1)] = *slot;
+
     *physAddr = pageFrame * PageSize + offset;
     ASSERT((*physAddr >= 0) && ((*physAddr + size) <= MemorySize));
     DEBUG('a', "phys addr = 0x%x\n", *physAddr);
@@ -21,6 +21,8 @@
 
 #include <strings.h> /* for bzero */
 
+static ObjectPool mailPool("mail", sizeof(Mail));
+
 //----------------------------------------------------------------------
 // Mail::Mail
 //      Initialize a single mail message, by concatenating the headers to
@@ -40,6 +42,24 @@ Mail::Mail(PacketHeader pktH, MailHeader mailH, char *msgData)
     bcopy(msgData, data, mailHdr.length);
 }
 
+//----------------------------------------------------------------------
+// Mail::operator new, Mail::operator delete
+//      A Mail is allocated for every message received, and freed once
+//	it has been read out of its mailbox: recycle them through a pool.
+//----------------------------------------------------------------------
+
+void *
+Mail::operator new(size_t size)
+{
+    return mailPool.Allocate(size);
+}
+
+void
+Mail::operator delete(void *p)
+{
+    mailPool.Free(p);
+}
+
 //----------------------------------------------------------------------
 // MailBox::MailBox
 //      Initialize a single mail box within the post office, so that it
@@ -261,8 +281,8 @@ PostOffice::PostalDelivery()
 void
 PostOffice::Send(PacketHeader pktHdr, MailHeader mailHdr, const char* data)
 {
-    char* buffer = new char[MaxPacketSize];	// space to hold concatenated
-						// mailHdr + data
+    char buffer[MaxPacketSize];		// space to hold concatenated
+					// mailHdr + data
 
     if (DebugIsEnabled('n')) {
 	printf("Post send: ");
@@ -285,9 +305,6 @@ PostOffice::Send(PacketHeader pktHdr, MailHeader mailHdr, const char* data)
     messageSent->P();			// wait for interrupt to tell us
 					// ok to send the next message
     sendLock->Release();
-
-    delete [] buffer;			// we've sent the message, so
-					// we can delete our buffer
 }
 
 //----------------------------------------------------------------------
@@ -65,6 +65,9 @@ class Mail {
 				// Initialize a mail message by
 				// concatenating the headers to the data
 
+     void *operator new(size_t size);	// messages come from mailPool
+     void operator delete(void *p);
+
      PacketHeader pktHdr;	// Header appended by Network
      MailHeader mailHdr;	// Header appended by PostOffice
      char data[MaxMailSize];	// Payload -- message data
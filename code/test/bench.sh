@@ -0,0 +1,155 @@
+#!/bin/sh
+# bench.sh
+#	Run the thread and process benchmarks (benchthread, benchprocess)
+#	at several concurrency levels, and print the results as CSV or
+#	JSON, one record per operation and concurrency level.
+#
+#	Run it from the build directory, where the kernels and the user
+#	programs are:
+#
+#		../test/bench.sh [-n kernel] [-r rounds] [-t "levels"]
+#			[-p "levels"] [-b build] [-f csv|json]
+#
+#	-n	the Nachos kernel to run (default ./nachos-step4)
+#	-r	rounds per run (default 20)
+#	-t	concurrency levels for the thread benchmark (default "1 2 3";
+#		a process can only have a few threads with the default
+#		user stack size)
+#	-p	concurrency levels for the process benchmark (default
+#		"1 2 4 8")
+#	-b	label of the build, to compare runs (default: the git commit)
+#	-f	output format (default csv)
+#
+#	Each record has the simulated ticks per operation, measured by the
+#	program with GetTicks, so they do not depend on the host.  The
+#	"_cycle" records also have the host time per cycle (create and
+#	join, or ForkExec and wait), in nanoseconds: the time of a run
+#	minus the time of a run with no rounds (which only starts and
+#	stops Nachos), divided by the number of cycles.  Host times vary
+#	from run to run; use enough rounds.
+
+kernel=./nachos-step4
+rounds=20
+threadLevels="1 2 3"
+processLevels="1 2 4 8"
+build=$(git rev-parse --short HEAD 2>/dev/null || echo unknown)
+format=csv
+
+usage() {
+	echo "usage: $0 [-n kernel] [-r rounds] [-t levels] [-p levels]" \
+		"[-b build] [-f csv|json]" >&2
+	exit 1
+}
+
+while getopts n:r:t:p:b:f: option; do
+	case $option in
+	n) kernel=$OPTARG ;;
+	r) rounds=$OPTARG ;;
+	t) threadLevels=$OPTARG ;;
+	p) processLevels=$OPTARG ;;
+	b) build=$OPTARG ;;
+	f) format=$OPTARG ;;
+	*) usage ;;
+	esac
+done
+case $format in
+csv|json) ;;
+*) usage ;;
+esac
+[ "$rounds" -gt 0 ] 2>/dev/null || usage
+if [ ! -x "$kernel" ]; then
+	echo "$0: no kernel $kernel (run from the build directory)" >&2
+	exit 1
+fi
+
+# now
+#	Print the host time, in nanoseconds.  "date +%N" is a GNU
+#	extension: elsewhere, ask perl, or make do with whole seconds.
+case $(date +%N) in
+''|*[!0-9]*)
+	if perl -MTime::HiRes -e 1 2>/dev/null; then
+		now() {
+			perl -MTime::HiRes=time -e 'printf "%.0f\n", time() * 1e9'
+		}
+	else
+		now() {
+			echo $(($(date +%s) * 1000000000))
+		}
+	fi
+	;;
+*)
+	now() {
+		date +%s%N
+	}
+	;;
+esac
+
+# run program concurrency rounds output
+#	Run one benchmark, saving its output; print the host time it took.
+run() {
+	start=$(now)
+	printf '%d\n%d\n' "$2" "$3" | "$kernel" -x "./$1" > "$4" 2>/dev/null
+	end=$(now)
+	echo $((end - start))
+}
+
+# measure program concurrency
+#	Print the records of one benchmark at one concurrency level, as
+#	"build operation concurrency count ticks wall" lines.  Fails if
+#	the benchmark printed no records.
+measure() {
+	output=$(mktemp)
+	empty=$(run "$1" "$2" 0 "$output")
+	full=$(run "$1" "$2" "$rounds" "$output")
+	if ! grep -q '^BENCH ' "$output"; then
+		echo "$0: $1 failed at concurrency $2:" >&2
+		cat "$output" >&2
+		rm -f "$output"
+		return 1
+	fi
+	grep '^BENCH ' "$output" | while read -r tag operation level count ticks; do
+		wall=
+		case $operation in
+		*_cycle) wall=$(((full - empty) / count)) ;;
+		esac
+		echo "$build $operation $level $count $ticks $wall"
+	done
+	rm -f "$output"
+}
+
+# The records are gathered in a file before being formatted: a failure
+# in a pipeline into awk would not be seen by the shell.
+records=$(mktemp)
+for level in $threadLevels; do
+	measure benchthread "$level" >> "$records" || { rm -f "$records"; exit 1; }
+done
+for level in $processLevels; do
+	measure benchprocess "$level" >> "$records" || { rm -f "$records"; exit 1; }
+done
+
+awk -v format="$format" '
+	BEGIN {
+		if (format == "csv")
+			print "build,operation,concurrency,count,ticks," \
+				"ticks_per_op,wall_ns_per_op"
+		else
+			print "["
+	}
+	{
+		perOp = sprintf("%.1f", $5 / $4)
+		if (format == "csv")
+			printf "%s,%s,%d,%d,%d,%s,%s\n", $1, $2, $3, $4, $5, perOp, $6
+		else {
+			if (NR > 1)
+				print ","
+			printf "  {\"build\": \"%s\", \"operation\": \"%s\", " \
+				"\"concurrency\": %d, \"count\": %d, \"ticks\": %d, " \
+				"\"ticks_per_op\": %s, \"wall_ns_per_op\": %s}", \
+				$1, $2, $3, $4, $5, perOp, ($6 == "") ? "null" : $6
+		}
+	}
+	END {
+		if (format == "json")
+			print "\n]"
+	}' "$records"
+rm -f "$records"
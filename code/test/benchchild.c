@@ -0,0 +1,9 @@
+// benchchild.c
+//      The process started by benchprocess: exits at once.
+
+#include "syscall.h"
+
+int main()
+{
+    return 0;
+}
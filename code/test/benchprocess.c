@@ -0,0 +1,69 @@
+// benchprocess.c
+//      Benchmark of the process system calls: how long it takes to start
+//      processes with ForkExec, and to wait for them once they exited.
+//
+//      Reads the concurrency (children alive at once) and the number of
+//      rounds from the console.  Each round starts that many copies of
+//      benchchild, which exits at once, and waits for them all.  Prints
+//      one line per operation, for test/bench.sh:
+//
+//              BENCH <operation> <concurrency> <count> <ticks>
+//
+//      process_forkexec is the ForkExec calls; process_wait_exit is the
+//      WaitProcess calls, which cover running the children to their
+//      Exit; process_cycle is both.
+
+#include "syscall.h"
+
+#define MAX_PROCESSES 32
+
+static void Report(char *operation, int concurrency, int count, int ticks)
+{
+    PutString("BENCH ");
+    PutString(operation);
+    PutChar(' ');
+    PutInt(concurrency);
+    PutChar(' ');
+    PutInt(count);
+    PutChar(' ');
+    PutInt(ticks);
+    PutChar('\n');
+}
+
+int main()
+{
+    int concurrency, rounds;
+    int children[MAX_PROCESSES];
+    int forkTicks = 0, waitTicks = 0;
+    int round, i, start;
+
+    GetInt(&concurrency);
+    GetInt(&rounds);
+    if (concurrency < 1 || concurrency > MAX_PROCESSES || rounds < 0) {
+        PutString("benchprocess: bad concurrency or rounds\n");
+        Exit(1);
+    }
+
+    for (round = 0; round < rounds; round++) {
+        start = GetTicks();
+        for (i = 0; i < concurrency; i++) {
+            children[i] = ForkExec("./benchchild");
+            if (children[i] < 0) {
+                PutString("benchprocess: concurrency too high\n");
+                Exit(1);
+            }
+        }
+        forkTicks += GetTicks() - start;
+
+        start = GetTicks();
+        for (i = 0; i < concurrency; i++)
+            WaitProcess(children[i]);
+        waitTicks += GetTicks() - start;
+    }
+
+    Report("process_forkexec", concurrency, rounds * concurrency, forkTicks);
+    Report("process_wait_exit", concurrency, rounds * concurrency, waitTicks);
+    Report("process_cycle", concurrency, rounds * concurrency,
+           forkTicks + waitTicks);
+    return 0;
+}
@@ -0,0 +1,74 @@
+// benchthread.c
+//      Benchmark of the user thread system calls: how long it takes to
+//      create threads, and to join them once they have exited.
+//
+//      Reads the concurrency (threads alive at once) and the number of
+//      rounds from the console.  Each round creates that many threads,
+//      which exit at once, and joins them all.  Prints one line per
+//      operation, for test/bench.sh:
+//
+//              BENCH <operation> <concurrency> <count> <ticks>
+//
+//      thread_create is the UserThreadCreate calls; thread_join_exit is
+//      the UserThreadJoin calls, which cover running the threads to
+//      their UserThreadExit; thread_cycle is both.
+
+#include "syscall.h"
+
+#define MAX_THREADS 16
+
+static void Report(char *operation, int concurrency, int count, int ticks)
+{
+    PutString("BENCH ");
+    PutString(operation);
+    PutChar(' ');
+    PutInt(concurrency);
+    PutChar(' ');
+    PutInt(count);
+    PutChar(' ');
+    PutInt(ticks);
+    PutChar('\n');
+}
+
+static void Worker(void *arg)
+{
+    UserThreadExit();
+}
+
+int main()
+{
+    int concurrency, rounds;
+    int threads[MAX_THREADS];
+    int createTicks = 0, joinTicks = 0;
+    int round, i, start;
+
+    GetInt(&concurrency);
+    GetInt(&rounds);
+    if (concurrency < 1 || concurrency > MAX_THREADS || rounds < 0) {
+        PutString("benchthread: bad concurrency or rounds\n");
+        Exit(1);
+    }
+
+    for (round = 0; round < rounds; round++) {
+        start = GetTicks();
+        for (i = 0; i < concurrency; i++) {
+            threads[i] = UserThreadCreate(Worker, 0);
+            if (threads[i] < 0) {
+                PutString("benchthread: concurrency too high\n");
+                Exit(1);
+            }
+        }
+        createTicks += GetTicks() - start;
+
+        start = GetTicks();
+        for (i = 0; i < concurrency; i++)
+            UserThreadJoin(threads[i]);
+        joinTicks += GetTicks() - start;
+    }
+
+    Report("thread_create", concurrency, rounds * concurrency, createTicks);
+    Report("thread_join_exit", concurrency, rounds * concurrency, joinTicks);
+    Report("thread_cycle", concurrency, rounds * concurrency,
+           createTicks + joinTicks);
+    return 0;
+}
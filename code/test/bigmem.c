@@ -0,0 +1,25 @@
+#include "syscall.h"
+
+// Fill an array about twice the size of physical memory, then read it
+// back twice.  Only runs with demand paging (nachos-step4-vm): the pages
+// are brought in as they are touched, and evicted to the swap file when
+// memory runs out, so every page must come back with what was written.
+
+#define WORDS 16000 // 500 pages of 128 bytes
+
+int big[WORDS];
+
+int main(){
+    int i, pass, errors = 0;
+
+    for(i = 0; i < WORDS; i++)
+        big[i] = i * 7;
+    for(pass = 0; pass < 2; pass++)
+        for(i = 0; i < WORDS; i++)
+            if(big[i] != i * 7)
+                errors++;
+    PutString("bigmem: ");
+    PutInt(errors);
+    PutString(" errors\n");
+    Exit(errors);
+}
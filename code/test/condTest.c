@@ -0,0 +1,30 @@
+#include "syscall.h"
+
+// Several threads exit at about the same time while main joins them one
+// by one.  Each exit broadcasts the join and exit conditions of the
+// process under its thread table lock, while the other exiting threads
+// queue up for that lock: the broadcasts must not give the lock away,
+// or the threads deadlock.  Run with -rs to mix up the exits.
+
+#define NB_THREADS 4
+
+void work(void *arg) {
+    int i, sum = 0;
+
+    for(i = 0; i < 200; i++)
+        sum += i;
+    UserThreadExit();
+}
+
+int main() {
+    int tids[NB_THREADS];
+    int i;
+
+    for(i = 0; i < NB_THREADS; i++)
+        tids[i] = UserThreadCreate(work, 0);
+    for(i = 0; i < NB_THREADS; i++)
+        if(tids[i] >= 0)
+            UserThreadJoin(tids[i]);
+    PutString("condTest: all threads joined\n");
+    return 0;
+}
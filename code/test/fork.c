@@ -0,0 +1,61 @@
+#include "syscall.h"
+
+// Fork the process: the child starts from a copy of the memory of the
+// parent, shared copy-on-write, so each one only sees its own writes.
+// The child changes a value and exits; the parent waits for it, and
+// checks its own value is untouched.  Then a user thread forks: the
+// child is a copy of that thread, and the process ends when it returns
+// from the thread function, so the parent thread can wait for it.  Not
+// available with demand paging.
+
+int value = 1;
+int threadChild = -1;
+
+void forkFromThread(void *arg){
+    int child;
+
+    child = Fork();
+    if(child == 0){
+        value = 3;
+        PutString("thread child: value ");
+        PutInt(value);
+        PutString("\n");
+        return; // exits the thread, so the child process
+    }
+    threadChild = child;
+    if(child > 0)
+        WaitProcess(child);
+}
+
+int main(){
+    int child, tid;
+
+    child = Fork();
+    if(child < 0){
+        PutString("fork: failed\n");
+        Exit(1);
+    }
+    if(child == 0){
+        value = 2;
+        PutString("child: value ");
+        PutInt(value);
+        PutString("\n");
+        Exit(0);
+    }
+    WaitProcess(child);
+    PutString("parent: child ");
+    PutInt(child);
+    PutString(" done, value ");
+    PutInt(value);
+    PutString("\n");
+
+    tid = UserThreadCreate(forkFromThread, 0);
+    if(tid >= 0)
+        UserThreadJoin(tid);
+    PutString("parent: thread child ");
+    PutInt(threadChild);
+    PutString(" done, value ");
+    PutInt(value);
+    PutString("\n");
+    Exit((value == 1 && threadChild > 0) ? 0 : 1);
+}
@@ -0,0 +1,68 @@
+#include "syscall.h"
+#include "usync.h"
+
+// Two threads add to a shared sum under a mutex, and hand each item of
+// a one-slot buffer to the main thread through condition variables.
+// Without contention, none of the locking enters the kernel.
+
+#define ITEMS 10
+
+mutex_t mutex;
+cond_t notEmpty, notFull;
+int sum;
+int slot, full;
+
+void producer(void *arg){
+    int id = (int)arg;
+    int i;
+
+    for(i = 0; i < ITEMS; i++){
+        MutexLock(&mutex);
+        sum++;
+        while(full)
+            CondWait(&notFull, &mutex);
+        slot = id;
+        full = 1;
+        CondSignal(&notEmpty);
+        MutexUnlock(&mutex);
+    }
+    UserThreadExit();
+}
+
+int main(){
+    int i, fromOne = 0, fromTwo = 0;
+
+    MutexInit(&mutex);
+    CondInit(&notEmpty);
+    CondInit(&notFull);
+    sum = 0;
+    full = 0;
+
+    int one = UserThreadCreate(producer, (void *)1);
+    int two = UserThreadCreate(producer, (void *)2);
+
+    for(i = 0; i < 2 * ITEMS; i++){
+        MutexLock(&mutex);
+        while(!full)
+            CondWait(&notEmpty, &mutex);
+        if(slot == 1)
+            fromOne++;
+        else
+            fromTwo++;
+        full = 0;
+        CondSignal(&notFull);
+        MutexUnlock(&mutex);
+    }
+
+    UserThreadJoin(one);
+    UserThreadJoin(two);
+
+    PutString("sum = ");
+    PutInt(sum);
+    PutString(", items from 1: ");
+    PutInt(fromOne);
+    PutString(", from 2: ");
+    PutInt(fromTwo);
+    PutChar('\n');
+    return 0;
+}
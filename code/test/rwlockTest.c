@@ -0,0 +1,78 @@
+#include "syscall.h"
+
+// Two readers and a writer share a pair of values, which the writer
+// keeps equal under the write lock: a reader that sees them differ has
+// run along with the writer (run with -rs, so that threads are
+// preempted).  Each round ends at a barrier, where the
+// last thread to arrive prints the state.
+
+#define ROUNDS 5
+
+rwlock_t lock;
+barrier_t barrier;
+int first, second;
+int torn;
+int spin;
+
+void reader(void *arg){
+    int i, j;
+
+    for(i = 0; i < ROUNDS; i++){
+        for(j = 0; j < 3; j++){
+            RWLockAcquireRead(lock);
+            if(first != second)
+                torn++;
+            RWLockRelease(lock);
+        }
+        if(BarrierWait(barrier) == 1){
+            PutString("round ");
+            PutInt(i);
+            PutString(": value ");
+            PutInt(first);
+            PutChar('\n');
+        }
+    }
+    UserThreadExit();
+}
+
+void writer(void *arg){
+    int i, k;
+
+    for(i = 0; i < ROUNDS; i++){
+        RWLockAcquireWrite(lock);
+        first++;
+        for(k = 0; k < 100; k++) // give the readers a chance to look
+            spin++;
+        second++;
+        RWLockRelease(lock);
+        if(BarrierWait(barrier) == 1){
+            PutString("round ");
+            PutInt(i);
+            PutString(": value ");
+            PutInt(first);
+            PutChar('\n');
+        }
+    }
+    UserThreadExit();
+}
+
+int main(){
+    lock = RWLockCreate(RW_FIFO);
+    barrier = BarrierCreate(3);
+    first = second = torn = 0;
+
+    int one = UserThreadCreate(reader, 0);
+    int two = UserThreadCreate(reader, 0);
+    int three = UserThreadCreate(writer, 0);
+
+    UserThreadJoin(one);
+    UserThreadJoin(two);
+    UserThreadJoin(three);
+
+    PutString("torn reads: ");
+    PutInt(torn);
+    PutChar('\n');
+    RWLockDestroy(lock);
+    BarrierDestroy(barrier);
+    return 0;
+}
@@ -1,5 +1,5 @@
 #include "syscall.h"
-sem_t *sem;
+sem_t sem;
 int sum;
 
 void t1(){
@@ -39,5 +39,6 @@ int main(){
 
     UserThreadJoin(one);
     UserThreadJoin(two);
+    SemDestroy(sem);
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,30 @@
+#include "syscall.h"
+
+// Run the same program several times, a few at once, then one after
+// the other.  Only the first run reads its code from the executable:
+// the next ones map the frames it was loaded in, read-only (see the
+// shared code pages in the paging statistics at the end).  With
+// demand paging, the code is read page by page instead, and not shared.
+
+#define RUNS 4
+
+int main(){
+    int pids[RUNS];
+    int i, pid;
+
+    for(i = 0; i < RUNS; i++)
+        pids[i] = ForkExec("./benchchild");
+    for(i = 0; i < RUNS; i++)
+        if(pids[i] >= 0)
+            WaitProcess(pids[i]);
+    for(i = 0; i < RUNS; i++){
+        pid = ForkExec("./benchchild");
+        if(pid < 0){
+            PutString("sharedtext: ForkExec failed\n");
+            Exit(1);
+        }
+        WaitProcess(pid);
+    }
+    PutString("sharedtext: done\n");
+    Exit(0);
+}
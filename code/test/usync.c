@@ -0,0 +1,153 @@
+/* usync.c
+ *	Mutexes and condition variables for user programs, built on
+ *	atomic operations in user mode and on FutexWait/FutexWake.  See
+ *	usync.h.
+ *
+ *	The mutex is the one of "Futexes Are Tricky" (U. Drepper): a
+ *	thread that finds the mutex locked marks it as contended (2)
+ *	before sleeping, so the unlocking thread knows it has to wake
+ *	someone; a thread woken up marks it contended again, since it
+ *	cannot tell whether others still wait.
+ */
+
+#include "syscall.h"
+#include "usync.h"
+
+#define WAKE_ALL 0x7fffffff
+
+/* The atomic operations retry until the SC succeeds, i.e. until no
+ * exception or context switch came between the LL and the SC.
+ * (noreorder, with explicit nops in the delay slots, since Nachos
+ * simulates the MIPS I load delay.)
+ */
+
+int AtomicCompareAndSwap(int *addr, int expected, int desired)
+{
+    int old, stored;
+
+    __asm__ __volatile__(
+        "	.set	push\n"
+        "	.set	noreorder\n"
+        "	.set	mips2\n"
+        "1:	ll	%0, 0(%2)\n"
+        "	nop\n"
+        "	bne	%0, %3, 2f\n"
+        "	nop\n"
+        "	move	%1, %4\n"
+        "	sc	%1, 0(%2)\n"
+        "	beq	%1, $0, 1b\n"
+        "	nop\n"
+        "2:\n"
+        "	.set	pop\n"
+        : "=&r"(old), "=&r"(stored)
+        : "r"(addr), "r"(expected), "r"(desired)
+        : "memory");
+    return old;
+}
+
+int AtomicExchange(int *addr, int value)
+{
+    int old, stored;
+
+    __asm__ __volatile__(
+        "	.set	push\n"
+        "	.set	noreorder\n"
+        "	.set	mips2\n"
+        "1:	ll	%0, 0(%2)\n"
+        "	move	%1, %3\n"
+        "	sc	%1, 0(%2)\n"
+        "	beq	%1, $0, 1b\n"
+        "	nop\n"
+        "	.set	pop\n"
+        : "=&r"(old), "=&r"(stored)
+        : "r"(addr), "r"(value)
+        : "memory");
+    return old;
+}
+
+int AtomicAdd(int *addr, int increment)
+{
+    int old, stored;
+
+    __asm__ __volatile__(
+        "	.set	push\n"
+        "	.set	noreorder\n"
+        "	.set	mips2\n"
+        "1:	ll	%0, 0(%2)\n"
+        "	nop\n"
+        "	addu	%1, %0, %3\n"
+        "	sc	%1, 0(%2)\n"
+        "	beq	%1, $0, 1b\n"
+        "	nop\n"
+        "	.set	pop\n"
+        : "=&r"(old), "=&r"(stored)
+        : "r"(addr), "r"(increment)
+        : "memory");
+    return old;
+}
+
+void MutexInit(mutex_t *mutex)
+{
+    mutex->state = 0;
+}
+
+void MutexLock(mutex_t *mutex)
+{
+    int state = AtomicCompareAndSwap(&mutex->state, 0, 1);
+
+    if (state == 0)
+        return;			/* uncontended: no system call */
+    if (state != 2)
+        state = AtomicExchange(&mutex->state, 2);
+    while (state != 0) {
+        FutexWait(&mutex->state, 2);
+        state = AtomicExchange(&mutex->state, 2);
+    }
+}
+
+int MutexTryLock(mutex_t *mutex)
+{
+    return AtomicCompareAndSwap(&mutex->state, 0, 1) == 0;
+}
+
+void MutexUnlock(mutex_t *mutex)
+{
+    if (AtomicExchange(&mutex->state, 0) == 2)
+        FutexWake(&mutex->state, 1);
+}
+
+void CondInit(cond_t *cond)
+{
+    cond->sequence = 0;
+    cond->waiters = 0;
+}
+
+void CondWait(cond_t *cond, mutex_t *mutex)
+{
+    int sequence;
+
+    AtomicAdd(&cond->waiters, 1);
+    sequence = cond->sequence;
+    MutexUnlock(mutex);
+    /* returns at once if a signal came since reading "sequence" */
+    FutexWait(&cond->sequence, sequence);
+    AtomicAdd(&cond->waiters, -1);
+
+    /* relock as contended: other waiters may have been woken too */
+    while (AtomicExchange(&mutex->state, 2) != 0)
+        FutexWait(&mutex->state, 2);
+}
+
+void CondSignal(cond_t *cond)
+{
+    AtomicAdd(&cond->sequence, 1);
+    if (cond->waiters > 0)
+        FutexWake(&cond->sequence, 1);
+}
+
+void CondBroadcast(cond_t *cond)
+{
+    AtomicAdd(&cond->sequence, 1);
+    if (cond->waiters > 0)
+        FutexWake(&cond->sequence, WAKE_ALL);
+}
@@ -0,0 +1,47 @@
+/* usync.h
+ *	Mutexes and condition variables for user programs, which only
+ *	enter the kernel when a thread has to wait, or to wake up one
+ *	that waits (see FutexWait and FutexWake in syscall.h).  Locking
+ *	and unlocking a mutex nobody else wants is a few instructions in
+ *	user mode, unlike SemP and SemV, which always trap.
+ *
+ *	Linked into every user program, with start.S.
+ */
+
+#ifndef USYNC_H
+#define USYNC_H
+
+/* Atomic operations on a word of memory, with LL/SC.  Each returns the
+ * value the word held before.
+ */
+int AtomicCompareAndSwap(int *addr, int expected, int desired);
+int AtomicExchange(int *addr, int value);
+int AtomicAdd(int *addr, int increment);
+
+/* A mutex: 0 when free, 1 when locked, 2 when locked and some thread
+ * may be waiting for it (then unlocking it has to call FutexWake).
+ */
+typedef struct {
+    int state;
+} mutex_t;
+
+void MutexInit(mutex_t *mutex);
+void MutexLock(mutex_t *mutex);
+int MutexTryLock(mutex_t *mutex);	/* 1 if locked, 0 if busy */
+void MutexUnlock(mutex_t *mutex);
+
+/* A condition variable, used with a mutex, with Mesa semantics: a
+ * woken thread has to check its condition again.
+ */
+typedef struct {
+    int sequence;	/* bumped by every signal and broadcast */
+    int waiters;	/* threads in CondWait, so signals can skip
+        		 * the system call when there are none */
+} cond_t;
+
+void CondInit(cond_t *cond);
+void CondWait(cond_t *cond, mutex_t *mutex);
+void CondSignal(cond_t *cond);
+void CondBroadcast(cond_t *cond);
+
+#endif /* USYNC_H */
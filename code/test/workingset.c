@@ -0,0 +1,32 @@
+#include "syscall.h"
+
+// Stream through an array larger than physical memory while reusing a
+// small hot table all along.  Only runs with demand paging
+// (nachos-step4-vm): with the clock replacement, the hot table keeps its
+// use bits set and stays resident, so the page faults reported at the
+// end are about those of the streamed array alone.  The streamed array
+// is only read after its first pass, so its pages are clean and need no
+// writeback when evicted again.
+
+#define WORDS 12000 // streamed: 375 pages of 128 bytes
+#define HOT 256     // hot table: 8 pages
+#define PASSES 3
+
+int stream[WORDS];
+int hot[HOT];
+
+int main(){
+    int i, pass, sum = 0;
+
+    for(i = 0; i < HOT; i++)
+        hot[i] = i;
+    for(i = 0; i < WORDS; i++)
+        stream[i] = 1;
+    for(pass = 0; pass < PASSES; pass++)
+        for(i = 0; i < WORDS; i++)
+            sum += stream[i] + hot[i % HOT];
+    PutString("workingset: sum ");
+    PutInt(sum);
+    PutString("\n");
+    Exit(0);
+}
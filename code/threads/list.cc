@@ -18,6 +18,8 @@
 #include "list.h"
 #include "copyright.h"
 
+static ObjectPool listElementPool("list element", sizeof(ListElement));
+
 //----------------------------------------------------------------------
 // ListElement::ListElement
 //      Initialize a list element, so it can be added somewhere on a list.
@@ -33,6 +35,18 @@ ListElement::ListElement(void *itemPtr, long long sortKey) {
     next = NULL; // assume we'll put it at the end of the list
 }
 
+//----------------------------------------------------------------------
+// ListElement::operator new, ListElement::operator delete
+//      A list element is allocated for every item put on a list, so
+//      they are recycled through a pool rather than the host heap.
+//----------------------------------------------------------------------
+
+void *ListElement::operator new(size_t size) {
+    return listElementPool.Allocate(size);
+}
+
+void ListElement::operator delete(void *p) { listElementPool.Free(p); }
+
 //----------------------------------------------------------------------
 // List::List
 //      Initialize a list, empty to start with.
@@ -116,6 +130,42 @@ void *List::Remove() {
     return SortedRemove(NULL); // Same as SortedRemove, but ignore the key
 }
 
+//----------------------------------------------------------------------
+// List::RemoveMatch
+//      Remove the first item on the list that passes a test, wherever
+//      it is on the list.
+//
+//      "match" is the test to apply to each item, front to back
+//      "wasFirst" is set to TRUE if the item was at the front of the list
+//
+// Returns:
+//      Pointer to removed item, NULL if no item passes the test.
+//----------------------------------------------------------------------
+
+void *List::RemoveMatch(MatchFunctionPtr match, bool *wasFirst) {
+    ListElement *element, *previous = NULL;
+    void *thing;
+
+    for (element = first; element != NULL; element = element->next) {
+        if ((*match)(element->item))
+            break;
+        previous = element;
+    }
+    if (element == NULL)
+        return NULL;
+
+    if (previous == NULL)
+        first = element->next;
+    else
+        previous->next = element->next;
+    if (last == element)
+        last = previous;
+    *wasFirst = (previous == NULL);
+    thing = element->item;
+    delete element;
+    return thing;
+}
+
 //----------------------------------------------------------------------
 // List::Mapcar
 //      Apply a function to each item on the list, by walking through
@@ -14,8 +14,12 @@
 #define LIST_H
 
 #include "copyright.h"
+#include "objectpool.h"
 #include "utility.h"
 
+// A test on a list item, for List::RemoveMatch
+typedef bool (*MatchFunctionPtr)(void *item);
+
 // The following class defines a "list element" -- which is
 // used to keep track of one item on a list.  It is equivalent to a
 // LISP cell, with a "car" ("next") pointing to the next element on the list,
@@ -28,6 +32,9 @@ class ListElement {
   public:
     ListElement(void *itemPtr, long long sortKey); // initialize a list element
 
+    void *operator new(size_t size); // list elements come from
+    void operator delete(void *p);   // listElementPool
+
     ListElement *next; // next element on list,
     // NULL if this is the last
     long long key; // priority, for a sorted list
@@ -48,6 +55,9 @@ class List {
     void Prepend(void *item); // Put item at the beginning of the list
     void Append(void *item);  // Put item at the end of the list
     void *Remove();           // Take item off the front of the list
+    void *RemoveMatch(MatchFunctionPtr match, bool *wasFirst);
+    // Take off the first item for which
+    // "match" is TRUE, if any
 
     void Mapcar(VoidFunctionPtr func); // Apply "func" to every element
     // on the list
@@ -0,0 +1,162 @@
+// lockstats.h
+//      Data structures for measuring the contention on kernel locks.
+//
+//      Every Lock and RWLock reports to a LockStats record: how many
+//      times it was acquired, how many of those had to wait for another
+//      thread, how long they waited, and how long the lock was held.
+//      All the locks with the same name share a record, so that, for
+//      instance, the thread table locks of all the address spaces are
+//      reported together, including those of processes that are gone.
+//      Statistics::Print reports every lock that was used, busiest
+//      first, to tell which locks are hot.
+//
+//      Times are in simulated ticks (see stats.h), passed in by the
+//      locks.
+//
+//      NOTE: the records have no lock of their own, for the same reason
+//      as ObjectPool (see objectpool.h); besides, the locks update them
+//      with interrupts disabled.
+
+#ifndef LOCKSTATS_H
+#define LOCKSTATS_H
+
+#include "copyright.h"
+#include "utility.h"
+
+#include <string.h>
+
+// The following class defines the statistics of the locks of one name.
+
+class LockStats {
+  public:
+    static LockStats *Find(const char *lockName); // The record of the
+    // locks named "lockName", created the first time
+
+    void Acquired(bool contended, long long waited) {
+        acquires++;
+        if (contended) {
+            contentions++;
+            waitTicks += waited;
+        }
+    }
+    // Count an acquisition; "waited" is the time spent waiting for the
+    // lock, if it was "contended"
+
+    void Released(long long held) {
+        holds++;
+        holdTicks += held;
+        if (held > maxHold)
+            maxHold = held;
+    }
+    // Count the end of a period of "held" ticks during which the lock
+    // was held (for an RWLock, by any number of readers)
+
+    static void PrintAll(); // Print the records of the locks used
+
+    static LockStats *firstStats; // All the records, linked by
+    // nextStats (defined in synch.cc)
+    LockStats *nextStats;
+
+  private:
+    LockStats(const char *lockName); // initialize an empty record
+
+    void Print(); // Print this record
+
+    char *name;       // of the locks, for the report
+    int instances;    // locks created with this name
+    long long acquires;    // times a lock was acquired
+    long long contentions; // ... after waiting for another thread
+    long long waitTicks;   // total time spent waiting
+    long long holds;       // periods during which a lock was held
+    long long holdTicks;   // total time held
+    long long maxHold;     // longest period
+};
+
+//----------------------------------------------------------------------
+// LockStats::LockStats
+//      Initialize an empty record, and add it to the list of all the
+//      records.
+//
+//      "lockName" is the name of the locks; it is copied, as it may be
+//              a buffer of the creator.
+//----------------------------------------------------------------------
+
+inline LockStats::LockStats(const char *lockName) {
+    name = new char[strlen(lockName) + 1];
+    strcpy(name, lockName);
+    instances = 0;
+    acquires = contentions = waitTicks = 0;
+    holds = holdTicks = maxHold = 0;
+    nextStats = firstStats;
+    firstStats = this;
+}
+
+//----------------------------------------------------------------------
+// LockStats::Find
+//      Return the record of the locks named "lockName", and count one
+//      more lock of that name.  A new lock name gets a new record.
+//----------------------------------------------------------------------
+
+inline LockStats *LockStats::Find(const char *lockName) {
+    LockStats *record;
+
+    if (lockName == NULL)
+        lockName = "(unnamed)";
+    for (record = firstStats; record != NULL; record = record->nextStats)
+        if (strcmp(record->name, lockName) == 0)
+            break;
+    if (record == NULL)
+        record = new LockStats(lockName);
+    record->instances++;
+    return record;
+}
+
+//----------------------------------------------------------------------
+// LockStats::Print
+//      Print the statistics of the locks of one name.
+//----------------------------------------------------------------------
+
+inline void LockStats::Print() {
+    printf("Lock \"%s\" (%d locks): acquired %lld, contended %lld (%.1f%%), "
+           "waited %lld ticks, held %.1f ticks on average, %lld at most\n",
+           name, instances, acquires, contentions,
+           100.0 * contentions / acquires, waitTicks,
+           (holds > 0) ? (double)holdTicks / holds : 0.0, maxHold);
+}
+
+//----------------------------------------------------------------------
+// LockStats::PrintAll
+//      Print the records of the locks that were acquired, the ones that
+//      waited the longest first, then the ones held the longest.
+//----------------------------------------------------------------------
+
+inline void LockStats::PrintAll() {
+    LockStats *record;
+    LockStats **sorted;
+    int count = 0, i, j;
+
+    for (record = firstStats; record != NULL; record = record->nextStats)
+        count++;
+    sorted = new LockStats *[count];
+    count = 0;
+    for (record = firstStats; record != NULL; record = record->nextStats) {
+        if (record->acquires == 0)
+            continue;
+        // insertion sort, by wait time then hold time
+        for (i = count; i > 0; i--) {
+            LockStats *other = sorted[i - 1];
+            if ((other->waitTicks > record->waitTicks) ||
+                ((other->waitTicks == record->waitTicks) &&
+                 (other->holdTicks >= record->holdTicks)))
+                break;
+            sorted[i] = other;
+        }
+        sorted[i] = record;
+        count++;
+    }
+    for (j = 0; j < count; j++)
+        sorted[j]->Print();
+    delete[] sorted;
+}
+
+#endif // LOCKSTATS_H
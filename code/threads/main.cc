@@ -8,8 +8,12 @@
 //
 //      Most of this file is not needed until later assignments.
 //
-// Usage: nachos -d <debugflags> -rs <random seed #>
-//              -s -x <nachos file> -c <consoleIn> <consoleOut>
+// Usage: nachos -d <debugflags> -rs <random seed #> -q <time slice>
+//              -sched <policy> -ss <stack size>
+//              -s -bb -prof [<symbol file>] -x <nachos file>
+//              -tlb <entries> -tlbp <policy>
+//              -c <consoleIn> <consoleOut>
+//              -snap <snapshot> <nachos file> -restore <snapshot>
 //              -f -cp <unix file> <nachos file>
 //              -p <nachos file> -r <nachos file> -l -D -t
 //              -n <network reliability> -m <machine id>
@@ -18,13 +22,30 @@
 //
 //    -d causes certain debugging messages to be printed (cf. utility.h)
 //    -rs causes Yield to occur at random (but repeatable) spots
+//    -q preempts the running thread after a fixed number of ticks
+//    -sched chooses the order of the ready threads: "fifo" (the default),
+//        "prio" (static thread priorities), or "mlfq" (multilevel
+//        feedback queue)
+//    -ss sets the size of kernel thread stacks, in words
 //    -z prints the copyright message
 //
 //  USER_PROGRAM
 //    -s causes user programs to be executed in single-step mode
+//    -bb runs user programs through the basic-block engine instead of
+//        the instruction-at-a-time interpreter
+//    -prof profiles user programs, and prints the report on halt; the
+//        optional symbol file ("nm" output) names the user functions
 //    -x runs a user program
+//    -snap runs a user program, saving a snapshot of the machine once
+//        the program is loaded
+//    -restore runs the user program saved in a snapshot, from there
 //    -c tests the console
 //
+//  USE_TLB
+//    -tlb sets the number of entries of the TLB
+//    -tlbp chooses the TLB entry replaced on a miss: "random" (the
+//        default), "fifo", or "lru"
+//
 //  FILESYS
 //    -f causes the physical disk to be formatted
 //    -cp copies a file from UNIX to Nachos
@@ -60,6 +81,8 @@ extern void ThreadTest(void),
     Copy(const char *unixFile, const char *nachosFile);
 extern void Print(char *file), PerformanceTest(void);
 extern void StartProcess(char *file), ConsoleTest(char *in, char *out);
+extern void SnapshotProcess(char *file, char *snapshot);
+extern void RestoreSnapshot(const char *snapshot);
 extern void SynchConsoleTest(char *in, char *out);
 extern void SynchConsoleTest_SI(char *in, char *out);
 extern void MailTest(int networkID);
@@ -98,6 +121,14 @@ int main(int argc, char **argv) {
             ASSERT(argc > 1);
             StartProcess(*(argv + 1));
             argCount = 2;
+        } else if (!strcmp(*argv, "-snap")) { // run, saving a snapshot
+            ASSERT(argc > 2);
+            SnapshotProcess(*(argv + 2), *(argv + 1));
+            argCount = 3;
+        } else if (!strcmp(*argv, "-restore")) { // run from a snapshot
+            ASSERT(argc > 1);
+            RestoreSnapshot(*(argv + 1));
+            argCount = 2;
         } else if (!strcmp(*argv, "-c")) { // test the console
             if (argc == 1)
                 ConsoleTest(NULL, NULL);
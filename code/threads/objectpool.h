@@ -0,0 +1,157 @@
+// objectpool.h
+//      Data structures for allocating small kernel objects of a fixed
+//      size without going through the host heap.
+//
+//      A few kinds of kernel objects are created and destroyed all the
+//      time: a PendingInterrupt for every device interrupt, a ListElement
+//      for every item put on a list, a Mail for every message received.
+//      Their classes get their storage from an ObjectPool: freed objects
+//      are kept on a free list and handed out again, and new ones are
+//      carved out of chunks of PoolChunkSize objects.  Chunks are never
+//      given back to the host, so in the steady state allocation is just
+//      a free list push or pop.
+//
+//      Each pool counts the objects in use ("live"), the most that were
+//      ever in use at once ("peak"), and how many it has carved out of
+//      chunks; Statistics::Print reports them for every pool.
+//
+//      NOTE: like List, a pool has no lock of its own.  It relies on no
+//      other thread running while one is inside a pool routine: Nachos
+//      threads run one at a time, and are only switched in Sleep, in
+//      Yield, or by an interrupt, which can only fire when simulated
+//      time advances -- and the pool routines do none of these.  Code
+//      that runs this way needs no lock; it would if kernel threads
+//      ever ran at the same time.
+
+#ifndef OBJECTPOOL_H
+#define OBJECTPOOL_H
+
+#include "copyright.h"
+#include "utility.h"
+
+#define PoolChunkSize 64 // objects allocated from the host at a time
+
+// The following class defines a pool of objects of one size.  Pools are
+// meant to be global variables, one per class, used by the class's own
+// operator new and operator delete:
+//
+//      void *operator new(size_t size) { return fooPool.Allocate(size); }
+//      void operator delete(void *p) { fooPool.Free(p); }
+
+class ObjectPool {
+  public:
+    ObjectPool(const char *poolName, int size); // initialize an empty pool
+
+    void *Allocate(size_t size); // Get storage for an object of "size"
+    // bytes (at most the size of the pool)
+    void Free(void *object); // Put an object back in the pool
+
+    void Print(); // Print the pool statistics
+
+    static ObjectPool *firstPool; // All the pools, linked by nextPool,
+    // for Statistics::Print (defined in stats.cc)
+    ObjectPool *nextPool;
+
+  private:
+    class FreeObject {
+      public:
+        FreeObject *next; // next free object, NULL if last
+    };
+
+    void Grow(); // Put a new chunk of objects on the free list
+
+    const char *name;     // for debugging and statistics
+    int objectSize;       // size of each object, in bytes
+    FreeObject *freeList; // objects available for Allocate
+    int live;             // objects allocated and not freed
+    int peak;             // largest value "live" has had
+    int carved;           // objects taken out of chunks so far
+};
+
+//----------------------------------------------------------------------
+// ObjectPool::ObjectPool
+//      Initialize an empty pool, and add it to the list of all pools.
+//
+//      "poolName" is the kind of object, for statistics.
+//      "size" is the size of each object, in bytes.  It is rounded up
+//              so that objects carved out of a chunk stay aligned for
+//              any field type (and can hold a free list link).
+//----------------------------------------------------------------------
+
+inline ObjectPool::ObjectPool(const char *poolName, int size) {
+    const int align = sizeof(long long);
+
+    name = poolName;
+    objectSize = divRoundUp(size, align) * align;
+    freeList = NULL;
+    live = peak = carved = 0;
+    nextPool = firstPool;
+    firstPool = this;
+}
+
+//----------------------------------------------------------------------
+// ObjectPool::Allocate
+//      Take an object off the free list, getting a new chunk from the
+//      host first if the list is empty.
+//
+//      "size" is the size requested by operator new.
+//----------------------------------------------------------------------
+
+inline void *ObjectPool::Allocate(size_t size) {
+    FreeObject *object;
+
+    ASSERT((int)size <= objectSize);
+    if (freeList == NULL)
+        Grow();
+    object = freeList;
+    freeList = object->next;
+    if (++live > peak)
+        peak = live;
+    return (void *)object;
+}
+
+//----------------------------------------------------------------------
+// ObjectPool::Free
+//      Put an object back on the free list.
+//
+//      "object" is the storage of an object obtained from Allocate.
+//----------------------------------------------------------------------
+
+inline void ObjectPool::Free(void *object) {
+    FreeObject *freed = (FreeObject *)object;
+
+    if (freed == NULL) // as with delete, freeing nothing is fine
+        return;
+    freed->next = freeList;
+    freeList = freed;
+    live--;
+}
+
+//----------------------------------------------------------------------
+// ObjectPool::Grow
+//      Allocate a chunk of PoolChunkSize objects from the host, and put
+//      them all on the free list.
+//----------------------------------------------------------------------
+
+inline void ObjectPool::Grow() {
+    char *chunk = new char[PoolChunkSize * objectSize];
+
+    for (int i = PoolChunkSize - 1; i >= 0; i--) {
+        FreeObject *object = (FreeObject *)(chunk + i * objectSize);
+        object->next = freeList;
+        freeList = object;
+    }
+    carved += PoolChunkSize;
+}
+
+//----------------------------------------------------------------------
+// ObjectPool::Print
+//      Print the statistics of the pool.
+//----------------------------------------------------------------------
+
+inline void ObjectPool::Print() {
+    printf("Pool %s: live %d, peak %d, allocated %d\n", name, live, peak,
+           carved);
+}
+
+#endif // OBJECTPOOL_H
@@ -11,8 +11,10 @@
 //      end up calling FindNextToRun(), and that would put us in an
 //      infinite loop.
 //
-//      Very simple implementation -- no priorities, straight FIFO.
-//      Might need to be improved in later assignments.
+//      The order in which ready threads run is up to a policy: FIFO by
+//      default, or static priorities, or a multilevel feedback queue.
+//      Within a ready list, a thread of the address space loaded in the
+//      machine may be run ahead of its turn (see TakeFrom).
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation
@@ -22,19 +24,245 @@
 #include "copyright.h"
 #include "system.h"
 
+//----------------------------------------------------------------------
+// IsSpaceLoaded
+//      Return TRUE if a ready thread runs in the address space whose page
+//      table is in the machine, so that switching to it is cheap.  The
+//      current thread, when it is preempted, does not count: it gets no
+//      advantage over the others.
+//----------------------------------------------------------------------
+
+static bool IsSpaceLoaded(void *item) {
+#ifdef USER_PROGRAM
+    Thread *thread = (Thread *)item;
+
+    return (thread != currentThread) && (thread->space != NULL) &&
+           thread->space->IsLoaded();
+#else
+    return FALSE;
+#endif
+}
+
+//----------------------------------------------------------------------
+// TakeFrom
+//      Take the next thread off a ready list, for a policy.
+//
+//      The first ready thread in the address space loaded in the machine
+//      goes first, so threads of one process tend to run back to back;
+//      but the thread at the front of the list is passed over at most
+//      MaxAffineRuns times in a row, so no process starves the others.
+//
+//      "list" is the ready list
+//      "affineRuns" counts the times the front was passed over
+//
+// Returns:
+//      The thread, or NULL if the list is empty.
+//----------------------------------------------------------------------
+
+static Thread *TakeFrom(List *list, int *affineRuns) {
+    Thread *thread = NULL;
+    bool wasFirst = TRUE;
+
+    if (*affineRuns < MaxAffineRuns)
+        thread = (Thread *)list->RemoveMatch(IsSpaceLoaded, &wasFirst);
+    if (thread == NULL)
+        thread = (Thread *)list->Remove();
+
+    if (wasFirst)
+        *affineRuns = 0;
+    else
+        (*affineRuns)++;
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// FifoPolicy::FifoPolicy, FifoPolicy::~FifoPolicy
+//      Initialize and de-allocate the ready list.
+//----------------------------------------------------------------------
+
+FifoPolicy::FifoPolicy() {
+    readyList = new List;
+    affineRuns = 0;
+}
+
+FifoPolicy::~FifoPolicy() { delete readyList; }
+
+//----------------------------------------------------------------------
+// FifoPolicy::Insert, FifoPolicy::Remove, FifoPolicy::Print
+//      Every thread goes to the back of the list.
+//----------------------------------------------------------------------
+
+void FifoPolicy::Insert(Thread *thread, ReadyReason why) {
+    readyList->Append((void *)thread);
+}
+
+Thread *FifoPolicy::Remove() { return TakeFrom(readyList, &affineRuns); }
+
+void FifoPolicy::Print() { readyList->Mapcar((VoidFunctionPtr)ThreadPrint); }
+
+//----------------------------------------------------------------------
+// PriorityPolicy::PriorityPolicy, PriorityPolicy::~PriorityPolicy
+//      Initialize and de-allocate the ready lists.
+//----------------------------------------------------------------------
+
+PriorityPolicy::PriorityPolicy() {
+    for (int i = 0; i < NumPriorities; i++)
+        readyLists[i] = new List;
+    affineRuns = 0;
+}
+
+PriorityPolicy::~PriorityPolicy() {
+    for (int i = 0; i < NumPriorities; i++)
+        delete readyLists[i];
+}
+
+//----------------------------------------------------------------------
+// PriorityPolicy::Insert
+//      Put a thread at the back of the list of its priority.
+//----------------------------------------------------------------------
+
+void PriorityPolicy::Insert(Thread *thread, ReadyReason why) {
+    readyLists[thread->getPriority()]->Append((void *)thread);
+}
+
+//----------------------------------------------------------------------
+// PriorityPolicy::Remove
+//      Take the next thread of the highest priority that has one.
+//----------------------------------------------------------------------
+
+Thread *PriorityPolicy::Remove() {
+    for (int i = NumPriorities - 1; i >= 0; i--)
+        if (!readyLists[i]->IsEmpty())
+            return TakeFrom(readyLists[i], &affineRuns);
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// PriorityPolicy::Precedes
+//      A thread preempts a thread of lower priority.
+//----------------------------------------------------------------------
+
+bool PriorityPolicy::Precedes(Thread *thread, Thread *running) {
+    return thread->getPriority() > running->getPriority();
+}
+
+void PriorityPolicy::Print() {
+    for (int i = NumPriorities - 1; i >= 0; i--)
+        readyLists[i]->Mapcar((VoidFunctionPtr)ThreadPrint);
+}
+
+//----------------------------------------------------------------------
+// FeedbackPolicy::FeedbackPolicy, FeedbackPolicy::~FeedbackPolicy
+//      Initialize and de-allocate the ready lists.
+//----------------------------------------------------------------------
+
+FeedbackPolicy::FeedbackPolicy() {
+    for (int i = 0; i < NumFeedbackLevels; i++)
+        readyLists[i] = new List;
+    affineRuns = 0;
+    epoch = 0;
+    nextBoost = BoostTicks;
+}
+
+FeedbackPolicy::~FeedbackPolicy() {
+    for (int i = 0; i < NumFeedbackLevels; i++)
+        delete readyLists[i];
+}
+
+//----------------------------------------------------------------------
+// FeedbackPolicy::Insert
+//      Put a thread at the back of the list of its level, after moving
+//      it to level 0 if it is new or a boost happened since it last ran,
+//      or down a level if it was preempted.
+//----------------------------------------------------------------------
+
+void FeedbackPolicy::Insert(Thread *thread, ReadyReason why) {
+    if ((why == ReadyCreated) || (thread->feedbackEpoch != epoch)) {
+        thread->feedbackLevel = 0;
+        thread->feedbackEpoch = epoch;
+    } else if ((why == ReadyPreempted) &&
+               (thread->feedbackLevel < NumFeedbackLevels - 1))
+        thread->feedbackLevel++;
+    readyLists[thread->feedbackLevel]->Append((void *)thread);
+}
+
+//----------------------------------------------------------------------
+// FeedbackPolicy::Boost
+//      Put every ready thread back at level 0.  Changing the epoch puts
+//      the other threads back at level 0 when they are next inserted.
+//----------------------------------------------------------------------
+
+void FeedbackPolicy::Boost() {
+    Thread *thread;
+
+    DEBUG('t', "Boosting all threads to feedback level 0\n");
+    epoch++;
+    for (int i = 1; i < NumFeedbackLevels; i++)
+        while ((thread = (Thread *)readyLists[i]->Remove()) != NULL) {
+            thread->feedbackLevel = 0;
+            thread->feedbackEpoch = epoch;
+            readyLists[0]->Append((void *)thread);
+        }
+}
+
+//----------------------------------------------------------------------
+// FeedbackPolicy::Remove
+//      Take the next thread of the most urgent level that has one,
+//      boosting everybody first if it is time.
+//----------------------------------------------------------------------
+
+Thread *FeedbackPolicy::Remove() {
+    if (stats->totalTicks >= nextBoost) {
+        Boost();
+        nextBoost = stats->totalTicks + BoostTicks;
+    }
+    for (int i = 0; i < NumFeedbackLevels; i++)
+        if (!readyLists[i]->IsEmpty())
+            return TakeFrom(readyLists[i], &affineRuns);
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// FeedbackPolicy::Precedes
+//      A thread preempts a thread of a less urgent level.
+//----------------------------------------------------------------------
+
+bool FeedbackPolicy::Precedes(Thread *thread, Thread *running) {
+    return thread->feedbackLevel < running->feedbackLevel;
+}
+
+void FeedbackPolicy::Print() {
+    for (int i = 0; i < NumFeedbackLevels; i++)
+        readyLists[i]->Mapcar((VoidFunctionPtr)ThreadPrint);
+}
+
 //----------------------------------------------------------------------
 // Scheduler::Scheduler
 //      Initialize the list of ready but not running threads to empty.
+//
+//      "type" is the policy ordering the ready threads.
 //----------------------------------------------------------------------
 
-Scheduler::Scheduler() { readyList = new List; }
+Scheduler::Scheduler(PolicyType type) {
+    switch (type) {
+    case PriorityScheduling:
+        policy = new PriorityPolicy;
+        break;
+    case FeedbackScheduling:
+        policy = new FeedbackPolicy;
+        break;
+    default:
+        policy = new FifoPolicy;
+        break;
+    }
+}
 
 //----------------------------------------------------------------------
 // Scheduler::~Scheduler
 //      De-allocate the list of ready threads.
 //----------------------------------------------------------------------
 
-Scheduler::~Scheduler() { delete readyList; }
+Scheduler::~Scheduler() { delete policy; }
 
 //----------------------------------------------------------------------
 // Scheduler::ReadyToRun
@@ -45,10 +273,43 @@ Scheduler::~Scheduler() { delete readyList; }
 //----------------------------------------------------------------------
 
 void Scheduler::ReadyToRun(Thread *thread) {
+    switch (thread->getStatus()) {
+    case JUST_CREATED:
+        MakeReady(thread, ReadyCreated);
+        break;
+    case BLOCKED:
+        MakeReady(thread, ReadyWoken);
+        break;
+    default:
+        MakeReady(thread, ReadyYielded);
+        break;
+    }
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Preempted
+//      Like ReadyToRun, for the current thread when the timer takes the
+//      CPU from it: policies may treat it as bound by the CPU.
+//----------------------------------------------------------------------
+
+void Scheduler::Preempted(Thread *thread) { MakeReady(thread, ReadyPreempted); }
+
+//----------------------------------------------------------------------
+// Scheduler::MakeReady
+//      Put a thread in the policy's queue.  If the thread was woken by an
+//      interrupt handler and the policy says it should run before the
+//      interrupted thread, switch to it when the handler returns.
+//----------------------------------------------------------------------
+
+void Scheduler::MakeReady(Thread *thread, ReadyReason why) {
     DEBUG('t', "Putting thread %s on ready list.\n", thread->getName());
 
     thread->setStatus(READY);
-    readyList->Append((void *)thread);
+    policy->Insert(thread, why);
+    if ((why == ReadyWoken) && interrupt->InHandler() &&
+        (currentThread->getStatus() == RUNNING) &&
+        policy->Precedes(thread, currentThread))
+        interrupt->YieldOnReturn(FALSE); // not the end of its slice
 }
 
 //----------------------------------------------------------------------
@@ -59,7 +320,7 @@ void Scheduler::ReadyToRun(Thread *thread) {
 //      Thread is removed from the ready list.
 //----------------------------------------------------------------------
 
-Thread *Scheduler::FindNextToRun() { return (Thread *)readyList->Remove(); }
+Thread *Scheduler::FindNextToRun() { return policy->Remove(); }
 
 //----------------------------------------------------------------------
 // Scheduler::Run
@@ -85,7 +346,8 @@ void Scheduler::Run(Thread *nextThread) {
 #ifdef USER_PROGRAM                     // ignore until running user programs
     if (currentThread->space != NULL) { // if this thread is a user program,
         currentThread->SaveUserState(); // save the user's CPU registers
-        currentThread->space->SaveState();
+        if (nextThread->space != currentThread->space)
+            currentThread->space->SaveState();
     }
 #endif
 
@@ -94,6 +356,9 @@ void Scheduler::Run(Thread *nextThread) {
 
     currentThread = nextThread;        // switch to the next thread
     currentThread->setStatus(RUNNING); // nextThread is now running
+    currentThread->sliceStart = stats->totalTicks; // with a new time slice
+    currentThread->numSlices++;
+    stats->numSlices++;
 
     DEBUG('t', "Switching from thread \"%s\" to thread \"%s\"\n",
           oldThread->getName(), nextThread->getName());
@@ -119,7 +384,12 @@ void Scheduler::Run(Thread *nextThread) {
 #ifdef USER_PROGRAM
     if (currentThread->space != NULL) {    // if there is an address space
         currentThread->RestoreUserState(); // to restore, do it.
-        currentThread->space->RestoreState();
+        if (currentThread->space->IsLoaded()) // same page table: keep the
+            stats->numSameSpaceSwitches++;    // cached translations
+        else {
+            currentThread->space->RestoreState();
+            stats->numCrossSpaceSwitches++;
+        }
     }
 #endif
 }
@@ -131,5 +401,5 @@ void Scheduler::Run(Thread *nextThread) {
 //----------------------------------------------------------------------
 void Scheduler::Print() {
     printf("Ready list contents:\n");
-    readyList->Mapcar((VoidFunctionPtr)ThreadPrint);
+    policy->Print();
 }
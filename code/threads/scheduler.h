@@ -13,24 +13,132 @@
 #include "list.h"
 #include "thread.h"
 
+// How many times in a row a policy may pass over the thread at the front
+// of a ready list, to run one in the address space already loaded in the
+// machine
+#define MaxAffineRuns 4
+
+// Policies available for ordering the ready threads (chosen with "-sched")
+enum PolicyType {
+    FifoScheduling,     // first come, first served
+    PriorityScheduling, // highest Thread priority first
+    FeedbackScheduling  // multilevel feedback queue
+};
+
+// Why a thread is being made ready to run
+enum ReadyReason {
+    ReadyCreated,  // just forked
+    ReadyWoken,    // was blocked, and was signalled
+    ReadyYielded,  // gave up the CPU on its own
+    ReadyPreempted // was running when its time slice ran out
+};
+
+// The following class defines the interface of a scheduling policy: the
+// data structure holding the ready threads, and the order in which they
+// are taken off it.  Like the scheduler, the policies assume interrupts
+// are disabled.
+
+class SchedulingPolicy {
+  public:
+    virtual ~SchedulingPolicy() {}
+
+    virtual void Insert(Thread *thread, ReadyReason why) = 0;
+    // Put a ready thread in the queue
+    virtual Thread *Remove() = 0; // Take off the thread to run next,
+    // NULL if there is none
+    virtual bool Precedes(Thread *thread, Thread *running) = 0;
+    // Should "thread", just made ready,
+    // take the CPU from "running"?
+    virtual void Print() = 0; // Print the ready threads
+};
+
+// First come, first served: one ready list.
+
+class FifoPolicy : public SchedulingPolicy {
+  public:
+    FifoPolicy();
+    ~FifoPolicy();
+
+    void Insert(Thread *thread, ReadyReason why);
+    Thread *Remove();
+    bool Precedes(Thread *thread, Thread *running) { return FALSE; }
+    void Print();
+
+  private:
+    List *readyList; // queue of threads that are ready to run,
+    // but not running
+    int affineRuns; // threads picked ahead of the front of
+    // readyList since it was last taken
+};
+
+// Static priorities: one ready list per priority, the highest non-empty
+// one runs first.  A thread made ready preempts a thread of lower
+// priority.
+
+class PriorityPolicy : public SchedulingPolicy {
+  public:
+    PriorityPolicy();
+    ~PriorityPolicy();
+
+    void Insert(Thread *thread, ReadyReason why);
+    Thread *Remove();
+    bool Precedes(Thread *thread, Thread *running);
+    void Print();
+
+  private:
+    List *readyLists[NumPriorities]; // indexed by Thread priority
+    int affineRuns;
+};
+
+// Multilevel feedback queue.  Threads start at level 0, the most urgent.
+// A thread preempted at the end of its time slice, so likely bound by
+// the CPU, moves down a level; one that blocks or yields keeps its level,
+// so threads waiting for I/O stay ahead of those computing.  Every
+// BoostTicks, all threads go back to level 0, so none starves.
+
+#define NumFeedbackLevels 3
+#define BoostTicks 10000
+
+class FeedbackPolicy : public SchedulingPolicy {
+  public:
+    FeedbackPolicy();
+    ~FeedbackPolicy();
+
+    void Insert(Thread *thread, ReadyReason why);
+    Thread *Remove();
+    bool Precedes(Thread *thread, Thread *running);
+    void Print();
+
+  private:
+    void Boost(); // Move every thread back to level 0
+
+    List *readyLists[NumFeedbackLevels]; // indexed by Thread level
+    int affineRuns;
+    unsigned int epoch;  // number of boosts so far; a thread whose
+    // feedbackEpoch is older gets level 0
+    long long nextBoost; // when to boost next
+};
+
 // The following class defines the scheduler/dispatcher abstraction --
 // the data structures and operations needed to keep track of which
 // thread is running, and which threads are ready but not running.
 
 class Scheduler {
   public:
-    Scheduler();  // Initialize list of ready threads
-    ~Scheduler(); // De-allocate ready list
+    Scheduler(PolicyType type); // Initialize list of ready threads
+    ~Scheduler();               // De-allocate ready list
 
     void ReadyToRun(Thread *thread); // Thread can be dispatched.
+    void Preempted(Thread *thread);  // Same, but thread was preempted
     Thread *FindNextToRun();         // Dequeue first thread on the ready
     // list, if any, and return thread.
     void Run(Thread *nextThread); // Cause nextThread to start running
     void Print();                 // Print contents of ready list
 
   private:
-    List *readyList; // queue of threads that are ready to run,
-    // but not running
+    void MakeReady(Thread *thread, ReadyReason why);
+
+    SchedulingPolicy *policy; // orders the ready threads
 };
 
 #endif // SCHEDULER_H
@@ -0,0 +1,148 @@
+// stackpool.h
+//      Data structures for recycling the execution stacks of kernel
+//      threads.
+//
+//      Every forked thread needs a stack, with unmapped pages on both
+//      sides to catch overflows.  Getting one from the host, and giving
+//      it back, takes several host system calls, which would dominate
+//      the cost of short-lived threads.  Instead, the stacks of deleted
+//      threads are kept on a free list and handed to new threads, and
+//      stacks only come from the host when the list is empty -- so in
+//      the steady state, creating and deleting a thread makes no host
+//      system call at all.
+//
+//      Stacks are mapped with ReserveBoundedArray, so the host only
+//      commits the pages a thread actually touched: a large stack size
+//      costs address space, not memory.  The size can be set on the
+//      command line ("-ss"); stacks of another size are not recycled.
+//
+//      NOTE: the pool has no lock of its own, for the same reason as
+//      ObjectPool (see objectpool.h).
+
+#ifndef STACKPOOL_H
+#define STACKPOOL_H
+
+#include "copyright.h"
+#include "utility.h"
+
+// The following class defines a pool of thread stacks of one size.
+// There is a single one, "stackPool", used by Thread::StackAllocate and
+// Thread::~Thread.
+
+class StackPool {
+  public:
+    StackPool(int words); // initialize an empty pool of stacks of
+    // "words" integers
+
+    void SetStackWords(int words); // Change the size of new stacks
+    int *Allocate(int *words);     // Get a stack; set "words" to its size
+    void Free(int *stack, int words); // Put a stack back in the pool
+
+    void Print(); // Print the pool statistics
+
+  private:
+    int stackWords; // size of the stacks in the pool
+    int *freeList;  // stacks available for Allocate; each one is linked
+    // to the next through its last word, which is in the page a thread
+    // touches first, so it is already committed
+    int live;     // stacks allocated and not freed
+    int peak;     // largest value "live" has had
+    int reserved; // stacks taken from the host so far
+    int released; // stacks given back to the host
+};
+
+extern StackPool stackPool; // defined in thread.cc
+
+//----------------------------------------------------------------------
+// StackPool::StackPool
+//      Initialize an empty pool.
+//
+//      "words" is the size of each stack, in integers.
+//----------------------------------------------------------------------
+
+inline StackPool::StackPool(int words) {
+    freeList = NULL;
+    live = peak = reserved = released = 0;
+    stackWords = 0;
+    SetStackWords(words);
+}
+
+//----------------------------------------------------------------------
+// StackPool::SetStackWords
+//      Set the size of the stacks handed out from now on, and give the
+//      free stacks of the old size back to the host.  Stacks still in
+//      use keep their size.
+//
+//      "words" is the size of each stack, in integers.
+//----------------------------------------------------------------------
+
+inline void StackPool::SetStackWords(int words) {
+    ASSERT(words > 0);
+    if (words == stackWords)
+        return;
+    while (freeList != NULL) {
+        int *stack = freeList;
+
+        freeList = (int *)stack[stackWords - 1];
+        ReleaseBoundedArray((char *)stack, stackWords * sizeof(int));
+        released++;
+    }
+    stackWords = words;
+}
+
+//----------------------------------------------------------------------
+// StackPool::Allocate
+//      Take a stack off the free list, or get a new one from the host if
+//      the list is empty.  The contents of the stack are garbage.
+//
+//      "words" is set to the size of the stack, in integers, to be
+//              passed back to Free.
+//----------------------------------------------------------------------
+
+inline int *StackPool::Allocate(int *words) {
+    int *stack = freeList;
+
+    if (stack != NULL)
+        freeList = (int *)stack[stackWords - 1];
+    else {
+        stack = (int *)ReserveBoundedArray(stackWords * sizeof(int));
+        reserved++;
+    }
+    if (++live > peak)
+        peak = live;
+    *words = stackWords;
+    return stack;
+}
+
+//----------------------------------------------------------------------
+// StackPool::Free
+//      Put a stack back on the free list; if the stack size has changed
+//      since it was allocated, give it back to the host instead.
+//
+//      "stack" is a stack obtained from Allocate.
+//      "words" is its size, as returned by Allocate.
+//----------------------------------------------------------------------
+
+inline void StackPool::Free(int *stack, int words) {
+    live--;
+    if (words != stackWords) {
+        ReleaseBoundedArray((char *)stack, words * sizeof(int));
+        released++;
+        return;
+    }
+    stack[stackWords - 1] = (int)freeList;
+    freeList = stack;
+}
+
+//----------------------------------------------------------------------
+// StackPool::Print
+//      Print the statistics of the pool.
+//----------------------------------------------------------------------
+
+inline void StackPool::Print() {
+    printf("Pool thread stack (%d bytes): live %d, peak %d, allocated %d, "
+           "released %d\n",
+           stackWords * (int)sizeof(int), live, peak, reserved, released);
+}
+
+#endif // STACKPOOL_H
@@ -2,7 +2,8 @@
 //      Routines for synchronizing threads.  Three kinds of
 //      synchronization routines are defined here: semaphores, locks
 //      and condition variables (the implementation of the last two
-//      are left to the reader).
+//      are left to the reader).  Reader-writer locks and barriers
+//      follow.
 //
 // Any implementation of a synchronization routine needs some
 // primitive atomic operation.  We assume Nachos is running on
@@ -89,80 +90,94 @@ void Semaphore::V() {
     (void)interrupt->SetLevel(oldLevel);
 }
 
-// Dummy functions -- so we can compile our later assignments
-// Note -- without a correct implementation of Condition::Wait(),
-// the test case in the network assignment won't work!
+LockStats *LockStats::firstStats = NULL; // each record adds itself
 
-//---------------------------------------------------------------------------------------------
+//----------------------------------------------------------------------
 // Lock::Lock
-//			Constructor that initializes a lock to use for synchronization
+//      Initialize a lock, so that it can be used for synchronization.
+//      Initially, no thread holds the lock.
 //
-//			Initilazes two semaphores a general lock and an inner lock to ensure exclusive 
-//          access to the operations and resources. Sets the ownerID to -1 to specify that
-//          no thread holds it yet
-//			
-//			Arguments:
-//				debugName: arbitrary name given to the lock
-//----------------------------------------------------------------------------------------------
+//      "debugName" is an arbitrary name, useful for debugging; locks
+//      with the same name share their statistics.
+//----------------------------------------------------------------------
 
 Lock::Lock(const char *debugName) {
     name = debugName;
-    ownerID = -1;
-    lock = new Semaphore("Lock semaphore", 1);
-    mutex = new Semaphore("Lock inner semaphore", 1);
+    owner = NULL;
+    queue = new List;
+    heldSince = 0;
+    lockStats = LockStats::Find(debugName);
 }
 
-//---------------------------------------------------------------------------------------------
+//----------------------------------------------------------------------
 // Lock::~Lock
-//			Destructor that deletes resources allocated to a lock
-//
-//			This function does not take arguments and returns no value
-//----------------------------------------------------------------------------------------------
+//      De-allocate the lock, when no longer needed.  Assume no one is
+//      still waiting for it!  Its statistics are kept in its LockStats
+//      record.
+//----------------------------------------------------------------------
 
-Lock::~Lock() {
-    delete lock;
-    delete mutex;
-}
+Lock::~Lock() { delete queue; }
 
-//---------------------------------------------------------------------------------------------
+//----------------------------------------------------------------------
 // Lock::Acquire
-//			Atomically wait for the lock to be free and then set it to busy
-//          Sets the holder of the lock to the actual thread ID, else we release
-//          the lock.
+//      Wait until the lock is FREE, then take it.  As with Semaphore::P,
+//      interrupts are disabled to check and change the state of the
+//      lock atomically.
 //
-//			This function does not take arguments and returns no value
-//----------------------------------------------------------------------------------------------
+//      If the lock is busy, the thread goes to sleep, and is only woken
+//      up by Release once it already owns the lock: it does not need to
+//      check again.
+//----------------------------------------------------------------------
 
 void Lock::Acquire() {
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
 
-    lock->P();
-
-    mutex->P();
-    if (ownerID == -1){ ownerID = currentThread->GetThreadID(); }
-	else { lock->V() ;}
-	mutex->V() ;
+    ASSERT(owner != currentThread); // locks are not recursive
+    if (owner == NULL) {
+        owner = currentThread;
+        heldSince = stats->totalTicks;
+        lockStats->Acquired(FALSE, 0);
+    } else {
+        long long waitingSince = stats->totalTicks;
+
+        queue->Append((void *)currentThread);
+        currentThread->Sleep(); // Release handed us the lock
+        ASSERT(owner == currentThread);
+        lockStats->Acquired(TRUE, stats->totalTicks - waitingSince);
+    }
+    (void)interrupt->SetLevel(oldLevel);
 }
 
-//---------------------------------------------------------------------------------------------
-// Lock::Acquire
-//			Atomically set the lock to be free. Wakes a waiting thread if any.
-//          Sets the holder of the lock to -1 to reflect that nobody holds it
-//          Only the thread that holds it can release it
+//----------------------------------------------------------------------
+// Lock::Release
+//      Give up the lock, handing it over to the first waiting thread if
+//      there is one, or setting it to FREE otherwise.
 //
-//			This function does not take arguments and returns no value
-//----------------------------------------------------------------------------------------------
+//      Only the thread that holds the lock may release it; a release
+//      by any other thread is ignored.
+//----------------------------------------------------------------------
 
 void Lock::Release() {
-    mutex->P();
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
 
-    if(ownerID == currentThread->GetThreadID()){
-        ownerID = -1;
-        lock->V();
+    if (owner == currentThread) {
+        lockStats->Released(stats->totalTicks - heldSince);
+        owner = (Thread *)queue->Remove();
+        if (owner != NULL) { // the new owner holds the lock from now on
+            heldSince = stats->totalTicks;
+            scheduler->ReadyToRun(owner);
+        }
     }
-
-    mutex->V();
+    (void)interrupt->SetLevel(oldLevel);
 }
 
+//----------------------------------------------------------------------
+// Lock::isHeldByCurrentThread
+//      Return TRUE if the current thread holds the lock.
+//----------------------------------------------------------------------
+
+bool Lock::isHeldByCurrentThread() { return owner == currentThread; }
+
 //---------------------------------------------------------------------------------------------
 // Condition::Condition
 //			Constructor that initializes a condition variable so that it can be used
@@ -175,9 +190,7 @@ void Lock::Release() {
 
 Condition::Condition(const char *debugName) {
     name = debugName;
-    waitingThreads = 0;
-    sleepLock = new Semaphore("Sleeping semaphore", 0);
-    mutex = new Semaphore("Inner lock semaphore", 1);
+    queue = new List;
 }
 
 //---------------------------------------------------------------------------------------------
@@ -188,28 +201,43 @@ Condition::Condition(const char *debugName) {
 //----------------------------------------------------------------------------------------------
 
 Condition::~Condition() {
-    delete sleepLock;
-    delete mutex;
+    delete queue;
 }
 
-void Condition::Wait(Lock *conditionLock) { 
-    mutex->P();
+//---------------------------------------------------------------------------------------------
+// Condition::Wait
+//			Releases the lock, sleeps until the condition is signaled, then
+//          re-acquires the lock
+//
+//			With interrupts disabled, the thread is queued on the CV and
+//          releases the lock before it sleeps, so that no signal can be
+//          lost in between.  Once woken up, it waits for the lock like
+//          any other thread
+//
+//			Arguments:
+//				conditionLock: a lock associated with the condition variable that
+//                  is held by the caller
+//----------------------------------------------------------------------------------------------
 
-    waitingThreads++;
+void Condition::Wait(Lock *conditionLock) {
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(conditionLock->isHeldByCurrentThread());
+    queue->Append((void *)currentThread);
     conditionLock->Release();
-    mutex->V();
-    sleepLock->P();
-    conditionLock->Acquire();
- }
+    currentThread->Sleep();
+    (void)interrupt->SetLevel(oldLevel);
 
+    conditionLock->Acquire();
+}
 
 //---------------------------------------------------------------------------------------------
 // Condition::Signal
 //			Wakes up one single thread that is waiting on the conditional variable
 //
-//			Acquires and releases the internal lock to ensure exclusive access to the condition
-//          variable during the operation. If there is at least one thread waiting on the 
-//          CV releases the associated semaphore and decrements the number of sleeping threads
+//			With interrupts disabled, moves the first waiting thread to the ready
+//          list, if there is one.  The caller keeps the lock: the woken thread
+//          takes it when it is released (Mesa semantics)
 //			
 //			Arguments:
 //				conditionLock: a lock associated with the condition variable that
@@ -217,26 +245,23 @@ void Condition::Wait(Lock *conditionLock) {
 //----------------------------------------------------------------------------------------------
 
 void Condition::Signal(Lock *conditionLock) {
-    mutex->P();
-
-    if(waitingThreads > 0){
-        conditionLock->Release(); // IF ERROR COME BACK HERE
-        sleepLock->V();
-        waitingThreads--;
-        conditionLock->Acquire();
-    }
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    Thread *thread;
 
-    mutex->V();
+    ASSERT(conditionLock->isHeldByCurrentThread());
+    thread = (Thread *)queue->Remove();
+    if (thread != NULL)
+        scheduler->ReadyToRun(thread);
+    (void)interrupt->SetLevel(oldLevel);
 }
 
 //---------------------------------------------------------------------------------------------
 // Condition::Broadcast
 //			Wakes up all threads that are waiting on the conditional variable
 //
-//			Acquires and releases the internal lock to ensure exclusive access to the condition
-//          variable during the operation. Iterates through all the threads waiting
-//          on the CV and signals each waiting thread by releasing the associated 
-//          semaphore and decrements the number of sleeping threads
+//			With interrupts disabled, moves every waiting thread to the ready list.
+//          As with Signal, the caller keeps the lock, and the woken threads
+//          take it in turn once it is released
 //			
 //			Arguments:
 //				conditionLock: a lock associated with the condition variable that
@@ -244,12 +269,291 @@ void Condition::Signal(Lock *conditionLock) {
 //----------------------------------------------------------------------------------------------
 
 void Condition::Broadcast(Lock *conditionLock) {
-    mutex->P();
-    while(waitingThreads > 0){
-        conditionLock->Release();
-        sleepLock->V();
-        waitingThreads--;
-        conditionLock->Acquire();
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    Thread *thread;
+
+    ASSERT(conditionLock->isHeldByCurrentThread());
+    while ((thread = (Thread *)queue->Remove()) != NULL)
+        scheduler->ReadyToRun(thread);
+    (void)interrupt->SetLevel(oldLevel);
+}
+
+// A thread blocked in RWLock::AcquireRead or AcquireWrite.  The record
+// lives on the stack of the blocked thread, and is on the "waiters"
+// list of the lock until the lock is handed over to the thread.
+
+class RWWaiter {
+  public:
+    Thread *thread; // the thread to wake up
+    bool writing;   // waiting in AcquireWrite?
+};
+
+// Matches for List::RemoveMatch
+static bool IsWaitingReader(void *item) { return !((RWWaiter *)item)->writing; }
+
+static bool IsWaitingWriter(void *item) { return ((RWWaiter *)item)->writing; }
+
+//----------------------------------------------------------------------
+// RWLock::RWLock
+//      Initialize a reader-writer lock, so that it can be used for
+//      synchronization.  Initially nobody holds the lock.
+//
+//      "debugName" is an arbitrary name, useful for debugging.
+//      "policy" is the order in which waiting threads get the lock.
+//----------------------------------------------------------------------
+
+RWLock::RWLock(const char *debugName, RWFairness policy) {
+    name = debugName;
+    fairness = policy;
+    readers = 0;
+    writer = NULL;
+    waitingReaders = waitingWriters = 0;
+    waiters = new List;
+    heldSince = 0;
+    lockStats = LockStats::Find(debugName);
+}
+
+//----------------------------------------------------------------------
+// RWLock::~RWLock
+//      De-allocate the lock, when no longer needed.  Assume no one
+//      holds it, or is waiting for it!
+//----------------------------------------------------------------------
+
+RWLock::~RWLock() { delete waiters; }
+
+//----------------------------------------------------------------------
+// RWLock::AcquireRead
+//      Wait until the lock can be shared with the other readers, then
+//      take a share of it.  Whether a reader may enter while threads are
+//      waiting depends on the fairness policy.
+//
+//      As with Semaphore::P, interrupts are disabled to check and
+//      change the state of the lock atomically.  If the reader has to
+//      wait, it is only woken up once the lock has been handed over to
+//      it, by Grant.
+//----------------------------------------------------------------------
+
+void RWLock::AcquireRead() {
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    bool enter;
+
+    ASSERT(writer != currentThread);
+    switch (fairness) {
+    case ReaderPreference:
+        enter = (writer == NULL);
+        break;
+    case WriterPreference:
+        enter = (writer == NULL) && (waitingWriters == 0);
+        break;
+    default:
+        enter = (writer == NULL) && waiters->IsEmpty();
+        break;
+    }
+
+    if (enter) {
+        if (readers++ == 0)
+            heldSince = stats->totalTicks;
+        lockStats->Acquired(FALSE, 0);
+    } else
+        Wait(FALSE);
+    (void)interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// RWLock::ReleaseRead
+//      Give back a share of the lock.  The last reader out hands the
+//      lock over to the waiting threads, if any.
+//----------------------------------------------------------------------
+
+void RWLock::ReleaseRead() {
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(readers > 0);
+    readers--;
+    if (readers == 0) {
+        lockStats->Released(stats->totalTicks - heldSince);
+        Grant();
+    }
+    (void)interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// RWLock::AcquireWrite
+//      Wait until nobody holds the lock, then take it.  A writer never
+//      overtakes a thread that is already waiting.
+//----------------------------------------------------------------------
+
+void RWLock::AcquireWrite() {
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(writer != currentThread);
+    if ((writer == NULL) && (readers == 0) && waiters->IsEmpty()) {
+        writer = currentThread;
+        heldSince = stats->totalTicks;
+        lockStats->Acquired(FALSE, 0);
+    } else
+        Wait(TRUE);
+    (void)interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// RWLock::ReleaseWrite
+//      Give back the lock, and hand it over to the waiting threads, if
+//      any.  Only the writer may release it.
+//----------------------------------------------------------------------
+
+void RWLock::ReleaseWrite() {
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(isWriteHeldByCurrentThread());
+    writer = NULL;
+    lockStats->Released(stats->totalTicks - heldSince);
+    Grant();
+    (void)interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// RWLock::isWriteHeldByCurrentThread
+//      Return TRUE if the current thread holds the lock for writing.
+//----------------------------------------------------------------------
+
+bool RWLock::isWriteHeldByCurrentThread() { return writer == currentThread; }
+
+//----------------------------------------------------------------------
+// RWLock::Wait
+//      Queue the current thread for the lock, and sleep until Grant
+//      hands the lock over to it.
+//
+//      "writing" -- is the thread waiting in AcquireWrite?
+//
+//      Called with interrupts disabled.
+//----------------------------------------------------------------------
+
+void RWLock::Wait(bool writing) {
+    RWWaiter waiter;
+    long long waitingSince = stats->totalTicks;
+
+    waiter.thread = currentThread;
+    waiter.writing = writing;
+    waiters->Append((void *)&waiter);
+    if (writing)
+        waitingWriters++;
+    else
+        waitingReaders++;
+    currentThread->Sleep(); // Grant made us a reader, or the writer
+    lockStats->Acquired(TRUE, stats->totalTicks - waitingSince);
+}
+
+//----------------------------------------------------------------------
+// RWLock::Grant
+//      The lock has become FREE: hand it over to the waiting threads
+//      the fairness policy lets in, and put them on the ready list.
+//      Either all the chosen readers, or a single writer, get the lock.
+//
+//      Called with interrupts disabled.
+//----------------------------------------------------------------------
+
+void RWLock::Grant() {
+    RWWaiter *waiter;
+    bool wasFirst;
+
+    ASSERT((writer == NULL) && (readers == 0));
+    heldSince = stats->totalTicks; // if anyone gets the lock
+
+    // pick the writer to let in, if any; otherwise, let readers in
+    switch (fairness) {
+    case ReaderPreference:
+        waiter = NULL;
+        if (waitingReaders == 0)
+            waiter = (RWWaiter *)waiters->RemoveMatch(IsWaitingWriter,
+                                                      &wasFirst);
+        break;
+    case WriterPreference:
+        waiter = (RWWaiter *)waiters->RemoveMatch(IsWaitingWriter,
+                                                  &wasFirst);
+        break;
+    default:
+        waiter = (RWWaiter *)waiters->Remove();
+        if ((waiter != NULL) && !waiter->writing) {
+            waiters->Prepend((void *)waiter); // a reader is first in line
+            waiter = NULL;
+        }
+        break;
+    }
+
+    if (waiter != NULL) {
+        waitingWriters--;
+        writer = waiter->thread;
+        scheduler->ReadyToRun(waiter->thread);
+        return;
     }
-    mutex->V();
+
+    // let in the readers: all of them, or for FIFO fairness only those
+    // ahead of the first writer
+    for (;;) {
+        if (fairness == FifoFairness) {
+            waiter = (RWWaiter *)waiters->Remove();
+            if ((waiter != NULL) && waiter->writing) {
+                waiters->Prepend((void *)waiter);
+                break;
+            }
+        } else
+            waiter = (RWWaiter *)waiters->RemoveMatch(IsWaitingReader,
+                                                      &wasFirst);
+        if (waiter == NULL)
+            break;
+        waitingReaders--;
+        readers++;
+        scheduler->ReadyToRun(waiter->thread);
+    }
+}
+
+//----------------------------------------------------------------------
+// Barrier::Barrier
+//      Initialize a barrier, so that it can be used for synchronization.
+//
+//      "debugName" is an arbitrary name, useful for debugging.
+//      "numThreads" is the number of threads that meet at each round.
+//----------------------------------------------------------------------
+
+Barrier::Barrier(const char *debugName, int numThreads) {
+    ASSERT(numThreads > 0);
+    name = debugName;
+    count = numThreads;
+    arrived = 0;
+    queue = new List;
+}
+
+//----------------------------------------------------------------------
+// Barrier::~Barrier
+//      De-allocate the barrier, when no longer needed.  Assume no one
+//      is still waiting at the barrier!
+//----------------------------------------------------------------------
+
+Barrier::~Barrier() { delete queue; }
+
+//----------------------------------------------------------------------
+// Barrier::Wait
+//      Wait until "count" threads have reached the barrier.  The last
+//      one to arrive wakes the others up, and starts a new round.
+//
+//      Returns TRUE in the last thread to arrive, FALSE in the others.
+//----------------------------------------------------------------------
+
+bool Barrier::Wait() {
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    Thread *thread;
+
+    if (++arrived < count) {
+        queue->Append((void *)currentThread);
+        currentThread->Sleep();
+        (void)interrupt->SetLevel(oldLevel);
+        return FALSE;
+    }
+
+    arrived = 0; // the round is complete
+    while ((thread = (Thread *)queue->Remove()) != NULL)
+        scheduler->ReadyToRun(thread);
+    (void)interrupt->SetLevel(oldLevel);
+    return TRUE;
 }
@@ -7,6 +7,10 @@
 //      interface is given -- they are to be implemented as part of
 //      the first assignment.
 //
+//      Two more are built directly on the thread primitives, like
+//      semaphores: reader-writer locks, which let any number of
+//      readers share the lock, and barriers.
+//
 //      Note that all the synchronization objects take a "name" as
 //      part of the initialization.  This is solely for debugging purposes.
 //
@@ -19,6 +23,7 @@
 
 #include "copyright.h"
 #include "list.h"
+#include "lockstats.h"
 #include "thread.h"
 
 // The following class defines a "semaphore" whose value is a non-negative
@@ -45,6 +50,10 @@ class Semaphore {
     void P(); // these are the only operations on a semaphore
     void V(); // they are both *atomic*
 
+    bool HasWaiters() { return !queue->IsEmpty(); } // is a thread
+    // blocked in P?  (so that it is not
+    // safe to delete the semaphore)
+
   private:
     const char *name; // useful for debugging
     int value;        // semaphore value, always >= 0
@@ -62,6 +71,14 @@ class Semaphore {
 // In addition, by convention, only the thread that acquired the lock
 // may release it.  As with semaphores, you can't read the lock value
 // (because the value might change immediately after you read it).
+//
+// When the lock is released while threads wait for it, it is handed
+// over directly to the first one: that thread owns the lock as soon as
+// it is put on the ready list, so that no other thread can take the
+// lock in between, and waiters get it in the order they arrived.
+//
+// Each lock reports how often it was contended, and for how long it was
+// held, to the LockStats record of its name (see lockstats.h).
 
 class Lock {
   public:
@@ -78,10 +95,12 @@ class Lock {
                                   // Condition variable ops below.
 
   private:
-    const char *name; // for debugging
-    int ownerID;
-    Semaphore *mutex;
-    Semaphore *lock;
+    const char *name;      // for debugging
+    Thread *owner;         // thread holding the lock, NULL if FREE
+    List *queue;           // threads waiting in Acquire, in order
+    long long heldSince;   // when the owner got the lock
+    LockStats *lockStats;  // contention statistics, shared by all the
+                           // locks of this name
 };
 
 // The following class defines a "condition variable".  A condition
@@ -133,8 +152,101 @@ class Condition {
 
   private:
     const char *name;
-    int waitingThreads;
-    Semaphore *mutex;
-    Semaphore *sleepLock;
+    List *queue; // threads waiting in Wait(), in order
+};
+
+// The following class defines a "reader-writer lock".  The lock can be
+// held by any number of readers at once, or by a single writer:
+//
+//      AcquireRead -- wait until no writer holds the lock (and, depending
+//              on the fairness policy, none is waiting), then share it
+//
+//      AcquireWrite -- wait until nobody holds the lock, then take it
+//
+//      ReleaseRead, ReleaseWrite -- give the lock back, handing it over
+//              to the threads waiting for it if it became free
+//
+// When the lock is released, it is handed over directly to the threads
+// chosen by the fairness policy, before they even run, so that no other
+// thread can slip in.  The policies are:
+//
+//      ReaderPreference -- readers are let in as long as no writer holds
+//              the lock.  Best for read-mostly data, but a steady flow
+//              of readers can starve the writers.
+//
+//      WriterPreference -- once a writer waits, new readers wait behind
+//              it.  Writers can starve the readers instead.
+//
+//      FifoFairness -- threads are let in in the order they arrived,
+//              readers in a row sharing the lock.  Nobody starves.
+//
+// Like locks, the lock cannot be acquired recursively, and only a thread
+// that acquired the lock should release it.
+
+enum RWFairness { ReaderPreference, WriterPreference, FifoFairness };
+
+class RWLock {
+  public:
+    RWLock(const char *debugName, RWFairness policy = FifoFairness);
+    // initialize the lock to be FREE
+    ~RWLock();                             // deallocate the lock
+    const char *getName() { return name; } // debugging assist
+
+    void AcquireRead(); // these operations are *atomic*
+    void ReleaseRead();
+    void AcquireWrite();
+    void ReleaseWrite();
+
+    bool isWriteHeldByCurrentThread(); // true if the current thread
+                                       // holds the lock for writing
+    bool IsReadHeld() { return readers > 0; } // held by any reader?
+    bool IsBusy() { // held, or waited for?  (so that it is not
+        return (readers > 0) || (writer != NULL) || !waiters->IsEmpty();
+    } // safe to delete the lock)
+
+  private:
+    void Wait(bool writing); // wait until the lock is handed over
+    void Grant();            // hand the lock over to waiting threads
+
+    const char *name;      // for debugging
+    RWFairness fairness;   // who is let in first
+    int readers;           // threads holding the lock for reading
+    Thread *writer;        // thread holding it for writing, or NULL
+    int waitingReaders;    // threads in "waiters", by mode
+    int waitingWriters;
+    List *waiters;         // threads waiting for the lock, in arrival
+                           // order (see RWWaiter in synch.cc)
+    long long heldSince;   // when the lock last went from FREE to held
+    LockStats *lockStats;  // contention statistics, as for Lock
+};
+
+// The following class defines a "barrier", at which a fixed number of
+// threads meet.  There is only one operation:
+//
+//      Wait() -- wait until "count" threads, including this one, have
+//              called Wait, then wake them all up.  The barrier is then
+//              ready for the next round.
+//
+// Wait returns TRUE in exactly one of the threads of each round -- the
+// last one to arrive -- so that a single thread can do the work that
+// follows the round.
+
+class Barrier {
+  public:
+    Barrier(const char *debugName, int numThreads); // "numThreads"
+    // threads meet at each round
+    ~Barrier();                                // deallocate the barrier
+    const char *getName() { return name; }     // debugging assist
+
+    bool Wait(); // *atomic*
+
+    bool HasWaiters() { return !queue->IsEmpty(); } // is a thread
+    // blocked in Wait?  (so that it is not safe to delete the barrier)
+
+  private:
+    const char *name; // for debugging
+    int count;        // threads that meet at each round
+    int arrived;      // threads that called Wait in the current round
+    List *queue;      // threads blocked in Wait
 };
 #endif // SYNCH_H
@@ -6,6 +6,10 @@
 // of liability and disclaimer of warranty provisions.
 
 #include "system.h"
+#include "stackpool.h"
+#ifdef USER_PROGRAM
+#include "profile.h"
+#endif
 #include "copyright.h"
 
 // This defines *all* of the global data structures used by Nachos.
@@ -18,6 +22,8 @@ Interrupt *interrupt;        // interrupt status
 Statistics *stats;           // performance metrics
 Timer *timer;                // the hardware timer device,
                              // for invoking context switches
+int timeSlice;               // ticks a thread runs before it is
+                             // preempted, 0 if not fixed ("-q")
 
 #ifdef USER_PROGRAM
 SynchConsole *synchconsole;
@@ -35,12 +41,19 @@ SynchDisk *synchDisk;
 Machine *machine;                                   
 SynchConsole *synchConsole;                         
 FrameProvider* frameProvider;                        
+TextCache *textCache;
 Lock* processLocks[TEMP_MAXPROC_NUMBER];             
 Condition* processConds[TEMP_MAXPROC_NUMBER];       
 int processTable[TEMP_MAXPROC_NUMBER];              
 int maxProcessID;  // keeps track of maximum process ID allocated so far
 unsigned int numProcess;
 Lock *processLock;
+#ifdef DEMAND_PAGING
+Pager *pager;
+#endif
+#ifdef USE_TLB
+TLBManager *tlbManager;
+#endif
 
 #endif
 
@@ -58,6 +71,9 @@ extern void Cleanup();
 //      This routine is called each time there is a timer interrupt,
 //      with interrupts disabled.
 //
+//      With a fixed time slice ("-q"), only preempt the current thread
+//      once it has run for that long.
+//
 //      Note that instead of calling Yield() directly (which would
 //      suspend the interrupt handler, not the interrupted thread
 //      which is what we wanted to context switch), we set a flag
@@ -69,7 +85,9 @@ extern void Cleanup();
 //              whether it needs it or not.
 //----------------------------------------------------------------------
 static void TimerInterruptHandler(int dummy) {
-    if (interrupt->getStatus() != IdleMode)
+    if ((interrupt->getStatus() != IdleMode) &&
+        ((timeSlice == 0) ||
+         (stats->totalTicks - currentThread->sliceStart >= timeSlice)))
         interrupt->YieldOnReturn();
 }
 
@@ -87,9 +105,17 @@ void Initialize(int argc, char **argv) {
     int argCount;
     const char *debugArgs = "";
     bool randomYield = FALSE;
+    PolicyType policy = FifoScheduling; // order of the ready threads
 
 #ifdef USER_PROGRAM
     bool debugUserProg = FALSE; // single step user program
+    bool blockEngine = FALSE;   // run user code a basic block at a time
+    bool profiling = FALSE;     // profile user programs
+    const char *symbolFile = NULL; // function names for the profile
+    int tlbEntries = TLBSize;   // size of the TLB, if there is one
+#endif
+#ifdef USE_TLB
+    TLBPolicy tlbPolicy = TLBRandom; // which TLB entry a miss replaces
 #endif
 #ifdef FILESYS_NEEDED
     bool format = FALSE; // format disk
@@ -114,10 +140,54 @@ void Initialize(int argc, char **argv) {
             // number generator
             randomYield = TRUE;
             argCount = 2;
+        } else if (!strcmp(*argv, "-q")) {
+            ASSERT(argc > 1);
+            timeSlice = atoi(*(argv + 1)); // preempt the running thread
+            ASSERT(timeSlice > 0);         // after that many ticks
+            argCount = 2;
+        } else if (!strcmp(*argv, "-ss")) {
+            ASSERT(argc > 1);
+            stackPool.SetStackWords(atoi(*(argv + 1))); // size of the
+            argCount = 2;                               // thread stacks
+        } else if (!strcmp(*argv, "-sched")) {
+            ASSERT(argc > 1);
+            if (!strcmp(*(argv + 1), "prio"))
+                policy = PriorityScheduling;
+            else if (!strcmp(*(argv + 1), "mlfq"))
+                policy = FeedbackScheduling;
+            else
+                ASSERT(!strcmp(*(argv + 1), "fifo"));
+            argCount = 2;
         }
 #ifdef USER_PROGRAM
         if (!strcmp(*argv, "-s"))
             debugUserProg = TRUE;
+        else if (!strcmp(*argv, "-bb"))
+            blockEngine = TRUE;
+        else if (!strcmp(*argv, "-prof")) {
+            profiling = TRUE;
+            if ((argc > 1) && (**(argv + 1) != '-')) {
+                symbolFile = *(argv + 1);
+                argCount = 2;
+            }
+        }
+#endif
+#ifdef USE_TLB
+        if (!strcmp(*argv, "-tlb")) {
+            ASSERT(argc > 1);
+            tlbEntries = atoi(*(argv + 1)); // entries in the TLB
+            ASSERT(tlbEntries > 0);
+            argCount = 2;
+        } else if (!strcmp(*argv, "-tlbp")) {
+            ASSERT(argc > 1);
+            if (!strcmp(*(argv + 1), "fifo"))
+                tlbPolicy = TLBFifo;
+            else if (!strcmp(*(argv + 1), "lru"))
+                tlbPolicy = TLBLru;
+            else
+                ASSERT(!strcmp(*(argv + 1), "random"));
+            argCount = 2;
+        }
 #endif
 #ifdef FILESYS_NEEDED
         if (!strcmp(*argv, "-f"))
@@ -139,9 +209,14 @@ void Initialize(int argc, char **argv) {
     DebugInit(debugArgs);        // initialize DEBUG messages
     stats = new Statistics();    // collect statistics
     interrupt = new Interrupt;   // start up interrupt handling
-    scheduler = new Scheduler(); // initialize the ready queue
-    if (randomYield)             // start the timer (if needed)
-        timer = new Timer(TimerInterruptHandler, 0, randomYield);
+    scheduler = new Scheduler(policy); // initialize the ready queue
+    if (timeSlice > 0) // check for the end of the time slice every
+        // TimerTicks, or every slice if that is shorter: a slice
+        // ends late by less than that period
+        timer = new Timer(TimerInterruptHandler, 0, FALSE,
+                          (timeSlice < TimerTicks) ? timeSlice : TimerTicks);
+    else if (randomYield) // start the timer (if needed)
+        timer = new Timer(TimerInterruptHandler, 0, randomYield, TimerTicks);
     
     threadToBeDestroyed = NULL;
 
@@ -159,17 +234,26 @@ void Initialize(int argc, char **argv) {
 
 #ifdef USER_PROGRAM
 
-    machine = new Machine(debugUserProg);                           // initializes the user-level machine
+    machine = new Machine(debugUserProg, blockEngine, tlbEntries);  // initializes the user-level machine
+    if (profiling)
+        machine->profile = new Profile(symbolFile);                 // counts where user programs spend their time
     synchConsole = new SynchConsole(NULL, NULL) ;                   // initializes the synchronized console
 	frameProvider = new FrameProvider(NumPhysPages);                // initializes to a frame tracker to the number of physical pages available
+    textCache = new TextCache();                                    // the code of executables is shared by the processes running them
 	for( int k = 0; k < 64; k++ ){                                  // initializes process related synchronization primitives and process tables
-		processLocks[k]=new Lock("Process Locks\n");                
+		processLocks[k]=new Lock("Process Locks");                
 		processConds[k]=new Condition("Process Condition\n");       
 		processTable[k]=0;                                          // initializes the system to "no active process"
 	}	
 	maxProcessID=0;                                                 // sets the initial process ID to 0
     numProcess = 1;                                                 // init with one process (the initial kernel process)
     processLock = new Lock("Process Counter Lock");                 // lock for process counter access
+#ifdef DEMAND_PAGING
+    pager = new Pager();                                            // pages of user programs are loaded on demand
+#endif
+#ifdef USE_TLB
+    tlbManager = new TLBManager(tlbPolicy);                         // the TLB is refilled by the kernel
+#endif
 
 #endif
 
@@ -197,6 +281,12 @@ void Cleanup() {
 #endif
 
 #ifdef USER_PROGRAM
+#ifdef DEMAND_PAGING
+    delete pager; // removes the swap file
+#endif
+#ifdef USE_TLB
+    delete tlbManager;
+#endif
     delete machine;
     delete synchConsole;
 #endif
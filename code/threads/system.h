@@ -30,9 +30,11 @@ extern Scheduler *scheduler;        // the ready list
 extern Interrupt *interrupt;        // interrupt status
 extern Statistics *stats;           // performance metrics
 extern Timer *timer;                // the hardware alarm clock
+extern int timeSlice;               // fixed time slice, 0 if none
 
 #ifdef USER_PROGRAM
 #include "machine.h"
+#include "textcache.h"
 extern Machine *machine;                                // user program memory and registers
 extern SynchConsole * synchConsole;                     // the interface for synchronised console I/O
 
@@ -41,6 +43,7 @@ extern SynchConsole * synchConsole;                     // the interface for syn
 #define MAX_FILENAME 100                                // Maximum length of file names
 
 extern FrameProvider *frameProvider;                    // Manages allocation and tracking of physical memory
+extern TextCache *textCache;                            // Keeps the code of executables, shared by their processes
 extern Lock* processLocks[TEMP_MAXPROC_NUMBER];         // Locks to synchronize access to process resources
 extern Condition* processConds[TEMP_MAXPROC_NUMBER];    // Conditions for inter-process communication
 extern int processTable[TEMP_MAXPROC_NUMBER];           // Tracks active processes
@@ -50,6 +53,15 @@ extern Lock *processLock;                               // Lock to protect the p
 
 extern void AcquireProcessLock();                       // Function to acquire the process lock
 extern void ReleaseProcessLock();                       // Function to release the process lock
+
+#ifdef DEMAND_PAGING
+#include "pager.h"
+extern Pager *pager;                                    // Brings the pages of user programs in on demand
+#endif
+#ifdef USE_TLB
+#include "tlbmanager.h"
+extern TLBManager *tlbManager;                          // Refills the TLB on a miss
+#endif
 #endif
 
 #ifdef FILESYS_NEEDED // FILESYS or FILESYS_STUB
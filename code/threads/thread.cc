@@ -17,6 +17,7 @@
 #include "thread.h"
 #include "copyright.h"
 #include "switch.h"
+#include "stackpool.h"
 #include "system.h"
 #include "threadparams.h"
 
@@ -25,6 +26,8 @@
                // execution stack, for detecting
                // stack overflows
 
+StackPool stackPool(StackSize); // the stacks of all the threads
+
 //----------------------------------------------------------------------
 // Thread::Thread
 //      Initialize a thread control block, so that we can then call
@@ -37,7 +40,13 @@ Thread::Thread(const char *threadName, int TID, int _stackPointer) {
     name = threadName;
     stackTop = NULL;
     stack = NULL;
+    stackSize = 0;
     status = JUST_CREATED;
+    priority = DefaultPriority;
+    feedbackLevel = 0;
+    feedbackEpoch = 0;
+    sliceStart = 0;
+    numSlices = numYields = numPreemptions = 0;
 
     threadID = TID;
     stackPointer = _stackPointer;
@@ -69,7 +78,7 @@ Thread::~Thread() {
 
     ASSERT(this != currentThread);
     if (stack != NULL)
-        DeallocBoundedArray((char *)stack, StackSize * sizeof(int));
+        stackPool.Free(stack, stackSize);
 }
 
 //----------------------------------------------------------------------
@@ -141,7 +150,7 @@ void Thread::Fork(VoidFunctionPtr func, int arg) {
 void Thread::CheckOverflow() {
     if (stack != NULL)
 #ifdef HOST_SNAKE // Stacks grow upward on the Snakes
-        ASSERT(stack[StackSize - 1] == STACK_FENCEPOST);
+        ASSERT(stack[stackSize - 1] == STACK_FENCEPOST);
 #else
         ASSERT(*stack == (int)STACK_FENCEPOST);
 #endif
@@ -168,6 +177,8 @@ void Thread::Finish() {
     ASSERT(this == currentThread);
 
     DEBUG('t', "Finishing thread \"%s\"\n", getName());
+    DEBUG('t', "Thread \"%s\": %d time slices, %d yields, %d preemptions\n",
+          getName(), numSlices, numYields, numPreemptions);
 
     // LB: Be careful to guarantee that no thread to be destroyed
     // is ever lost
@@ -207,12 +218,56 @@ void Thread::Yield() {
 
     nextThread = scheduler->FindNextToRun();
     if (nextThread != NULL) {
+        numYields++;
+        stats->numYields++;
         scheduler->ReadyToRun(this);
         scheduler->Run(nextThread);
     }
     (void)interrupt->SetLevel(oldLevel);
 }
 
+//----------------------------------------------------------------------
+// Thread::Preempt
+//      Like Yield, but called when an interrupt takes the CPU from the
+//      current thread, so that it is counted apart from a thread giving
+//      up the CPU on its own.
+//
+//      "endOfSlice" -- TRUE if the timer ended the time slice of the
+//      thread, so that the scheduling policy sees it preempted; FALSE
+//      if it only makes way for a thread a handler woke up, and keeps
+//      its standing with the policy
+//----------------------------------------------------------------------
+
+void Thread::Preempt(bool endOfSlice) {
+    Thread *nextThread;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(this == currentThread);
+
+    DEBUG('t', "Preempting thread \"%s\"\n", getName());
+
+    // unlike Yield, the thread competes with the ready threads: under a
+    // priority policy, it may still be the one to run
+    numPreemptions++;
+    stats->numPreemptions++;
+    if (endOfSlice)
+        scheduler->Preempted(this);
+    else
+        scheduler->ReadyToRun(this);
+    nextThread = scheduler->FindNextToRun();
+    if (nextThread != this)
+        scheduler->Run(nextThread);
+    else {
+        setStatus(RUNNING);
+        if (endOfSlice) { // a new time slice, on the same thread
+            sliceStart = stats->totalTicks;
+            numSlices++;
+            stats->numSlices++;
+        }
+    }
+    (void)interrupt->SetLevel(oldLevel);
+}
+
 //----------------------------------------------------------------------
 // Thread::Sleep
 //      Relinquish the CPU, because the current thread is blocked
@@ -241,6 +296,10 @@ void Thread::Sleep() {
     DEBUG('t', "Sleeping thread \"%s\"\n", getName());
 
     status = BLOCKED;
+    if (threadToBeDestroyed != this) {
+        numYields++;
+        stats->numYields++;
+    }
     while ((nextThread = scheduler->FindNextToRun()) == NULL)
         interrupt->Idle(); // no one to run, wait for an interrupt
 
@@ -320,19 +379,19 @@ void ThreadPrint(int arg) {
 //----------------------------------------------------------------------
 
 void Thread::StackAllocate(VoidFunctionPtr func, int arg) {
-    stack = (int *)AllocBoundedArray(StackSize * sizeof(int));
+    stack = stackPool.Allocate(&stackSize);
 
 #ifdef HOST_SNAKE
     // HP stack works from low addresses to high addresses
     stackTop = stack + 16; // HP requires 64-byte frame marker
-    stack[StackSize - 1] = STACK_FENCEPOST;
+    stack[stackSize - 1] = STACK_FENCEPOST;
 #else
     // i386 & MIPS & SPARC stack works from high addresses to low addresses
 #ifdef HOST_SPARC
     // SPARC stack must contains at least 1 activation record to start with.
-    stackTop = stack + StackSize - 96;
+    stackTop = stack + stackSize - 96;
 #else // HOST_MIPS  || HOST_i386
-    stackTop = stack + StackSize - 4; // -4 to be on the safe side!
+    stackTop = stack + stackSize - 4; // -4 to be on the safe side!
 #ifdef HOST_i386
     // the 80386 passes the return address on the stack.  In order for
     // SWITCH() to go to ThreadRoot when we switch to this thread, the
@@ -386,6 +445,7 @@ void Thread::SaveUserState() {
 void Thread::RestoreUserState() {
     for (int i = 0; i < NumTotalRegs; i++)
         machine->WriteRegister(i, userRegisters[i]);
+    machine->linkAddress = -1; // another thread may have run since its LL
 }
 
 // MULTI-THREADING PURPOSE
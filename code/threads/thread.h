@@ -50,7 +50,8 @@
 // For simplicity, this is just the max over all architectures.
 #define MachineStateSize 18
 
-// Size of the thread's private execution stack.
+// Size of the thread's private execution stack, unless changed with
+// "-ss" (see stackpool.h).
 // WATCH OUT IF THIS ISN'T BIG ENOUGH!!!!!
 #define StackSize (4 * 1024) // in words
 
@@ -60,6 +61,11 @@ enum ThreadStatus { JUST_CREATED, RUNNING, READY, BLOCKED };
 // external function, dummy routine whose sole job is to call Thread::Print
 extern void ThreadPrint(int arg);
 
+// Thread priorities, for the PriorityScheduling policy (see scheduler.h):
+// from 0 to NumPriorities - 1, the highest runs first
+#define NumPriorities 8
+#define DefaultPriority 3
+
 // The following class defines a "thread control block" -- which
 // represents a single thread of execution.
 //
@@ -90,6 +96,8 @@ class Thread {
     void Fork(VoidFunctionPtr func, int arg); // Make thread run (*func)(arg)
     void Yield();                             // Relinquish the CPU if any
     // other thread is runnable
+    void Preempt(bool endOfSlice = TRUE); // Same, when an interrupt
+    // takes the CPU (the time slice is over, or not)
     void Sleep(); // Put the thread to sleep and
     // relinquish the processor
     void Finish(); // The thread is done executing
@@ -97,9 +105,26 @@ class Thread {
     void CheckOverflow(); // Check if thread has
     // overflowed its stack
     void setStatus(ThreadStatus st) { status = st; }
+    ThreadStatus getStatus() { return status; }
+    int getPriority() { return priority; }
+    void setPriority(int p) {
+        ASSERT((p >= 0) && (p < NumPriorities));
+        priority = p;
+    }
     const char *getName() { return (name); }
     void Print() { printf("%s, ", name); }
 
+    int feedbackLevel;          // for the FeedbackScheduling policy:
+    unsigned int feedbackEpoch; // see scheduler.h
+
+    // time slice accounting
+    long long sliceStart; // when the thread last got the CPU
+    int numSlices;        // times it got the CPU
+    int numYields;        // times it gave the CPU up on its own
+    // (Yield, or blocking)
+    int numPreemptions;   // times an interrupt took the CPU from it
+    // (the timer, or a handler waking a thread)
+
     // MULTI-THREADING PURPOSE
     int GetThreadID(){return (threadID);}
     void SetThreadID(int ID);
@@ -113,8 +138,10 @@ class Thread {
     int *stack; // Bottom of the stack
     // NULL if this is the main thread
     // (If NULL, don't deallocate stack)
+    int stackSize; // in words, as allocated from stackPool
     ThreadStatus status; // ready, running or blocked
     const char *name;
+    int priority; // static priority, see setPriority
 
     // MULTI-THREADING PURPOSE
     int threadID; //id of the thread
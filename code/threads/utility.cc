@@ -17,8 +17,7 @@
 #include "/usr/include/stdarg.h"
 #endif
 
-static const char *enableFlags =
-    NULL; // controls which DEBUG messages are printed
+bool debugFlags[256]; // controls which DEBUG messages are printed
 
 //----------------------------------------------------------------------
 // DebugInit
@@ -31,34 +30,26 @@ static const char *enableFlags =
 //              to be enabled.
 //----------------------------------------------------------------------
 
-void DebugInit(const char *flagList) { enableFlags = flagList; }
+void DebugInit(const char *flagList) {
+    bool all = (strchr(flagList, '+') != NULL);
 
-//----------------------------------------------------------------------
-// DebugIsEnabled
-//      Return TRUE if DEBUG messages with "flag" are to be printed.
-//----------------------------------------------------------------------
-
-bool DebugIsEnabled(char flag) {
-    if (enableFlags != NULL)
-        return (strchr(enableFlags, flag) != 0) ||
-               (strchr(enableFlags, '+') != 0);
-    else
-        return FALSE;
+    for (int c = 0; c < 256; c++)
+        debugFlags[c] = all;
+    for (; *flagList != '\0'; flagList++)
+        debugFlags[(unsigned char)*flagList] = TRUE;
 }
 
 //----------------------------------------------------------------------
-// DEBUG
-//      Print a debug message, if flag is enabled.  Like printf,
-//      only with an extra argument on the front.
+// DebugPrint
+//      Print a debug message.  Like printf; DEBUG calls us only when
+//      its flag is enabled.
 //----------------------------------------------------------------------
 
-void DEBUG(char flag, const char *format, ...) {
-    if (DebugIsEnabled(flag)) {
-        va_list ap;
-        // You will get an unused variable message here -- ignore it.
-        va_start(ap, format);
-        vfprintf(stdout, format, ap);
-        va_end(ap);
-        fflush(stdout);
-    }
+void DebugPrint(const char *format, ...) {
+    va_list ap;
+    // You will get an unused variable message here -- ignore it.
+    va_start(ap, format);
+    vfprintf(stdout, format, ap);
+    va_end(ap);
+    fflush(stdout);
 }
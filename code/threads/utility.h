@@ -53,13 +53,32 @@ typedef void (*VoidNoArgFunctionPtr)();
 #include "sysdep.h"
 
 // Interface to debugging routines.
+//
+// DebugInit turns the flag string into a table indexed by flag character,
+// so DebugIsEnabled and DEBUG are a single load and test, done in line
+// because the simulator checks flags on every instruction and memory
+// access.  Kernels compiled with -DNO_DEBUG (the release flavors) compile
+// them down to dead code instead.
 
 extern void DebugInit(const char *flags); // enable printing debug messages
 
-extern bool DebugIsEnabled(char flag); // Is this debug flag enabled?
+extern bool debugFlags[256]; // debugFlags[c] is TRUE if flag c is enabled
+
+extern void DebugPrint(const char *format, ...); // Print a debug message
+
+#ifdef NO_DEBUG
+#define DebugIsEnabled(flag) FALSE
+#else
+#define DebugIsEnabled(flag) (debugFlags[(unsigned char)(flag)])
+#endif
 
-extern void DEBUG(char flag, const char *format, ...); // Print debug message
-                                                       // if flag is enabled
+// Print a debug message if flag is enabled; the arguments are only
+// evaluated in that case.
+#define DEBUG(flag, ...)                                                       \
+    do {                                                                       \
+        if (DebugIsEnabled(flag))                                              \
+            DebugPrint(__VA_ARGS__);                                           \
+    } while (0)
 
 //----------------------------------------------------------------------
 // ASSERT
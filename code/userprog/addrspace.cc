@@ -22,14 +22,17 @@
 
 #include "synch.h"
 
+#include <string.h>  /* for memcpy */
 #include <strings.h> /* for bzero */
 
 #define UserThreadStackSize (PageSize * 2)
 #define UserThreadMax UserStackSize / UserThreadStackSize
 
+#ifndef DEMAND_PAGING
 static void ReadAtVirtual(OpenFile *executable, int virtualaddr, 
 		int numBytes, int position, 
 		TranslationEntry *pageTable, unsigned numPages) ; 
+#endif
 
 //----------------------------------------------------------------------
 // SwapHeader
@@ -63,6 +66,12 @@ static void SwapHeader(NoffHeader *noffH) {
 //      memory.  For now, this is really simple (1:1), since we are
 //      only uniprogramming, and we have a single unsegmented page table
 //
+//      With DEMAND_PAGING, nothing is loaded: the pages are brought in
+//      as the program touches them, so the executable stays open, and
+//      belongs to the address space.  Otherwise, the pages holding
+//      nothing but code are read-only, and shared with the other
+//      processes running the same executable (see textcache.h).
+//
 //      "executable" is the file containing the object code to load into memory
 //----------------------------------------------------------------------
 
@@ -70,6 +79,7 @@ AddrSpace::AddrSpace(OpenFile *executable) {
     NoffHeader noffH;
     unsigned int i, size;
 
+    handles = NULL; // until InitSpaceSetup
 
     executable->ReadAt((char *)&noffH, sizeof(noffH), 0);
     if ((noffH.noffMagic != NOFFMAGIC) &&
@@ -86,6 +96,32 @@ AddrSpace::AddrSpace(OpenFile *executable) {
     numPages = divRoundUp(size, PageSize);
     size = numPages * PageSize;
 
+#ifdef DEMAND_PAGING
+    // nothing is loaded yet: every page is brought in by the pager
+    // (see vm/pager.h) the first time it is touched
+    ASSERT(numPages <= NumSwapPages); // check we're not trying
+    // to run anything larger than the swap file
+
+    DEBUG('a', "Initializing address space, num pages %d, size %d\n", numPages,
+          size);
+    pageTable = new TranslationEntry[numPages];
+    swapSlots = new int[numPages];
+    for (i = 0; i < numPages; i++) {
+        pageTable[i].virtualPage = i;
+        pageTable[i].physicalPage = -1;
+        pageTable[i].valid = FALSE;
+        pageTable[i].use = FALSE;
+        pageTable[i].dirty = FALSE;
+        pageTable[i].readOnly = FALSE;
+        swapSlots[i] = -1;
+    }
+    executableFile = executable; // closed with the address space
+    codeSegment = noffH.code;
+    initDataSegment = noffH.initData;
+    copyOnWrite = new bool[numPages];
+    for (i = 0; i < numPages; i++)
+        copyOnWrite[i] = FALSE;
+#else
     ASSERT(numPages <= NumPhysPages); // check we're not trying
     // to run anything too big --
     // at least until we have
@@ -96,17 +132,55 @@ AddrSpace::AddrSpace(OpenFile *executable) {
           size);
     // first, set up the translation
     pageTable = new TranslationEntry[numPages];
-
-
-    if (frameProvider->NumAvailFrame() < numPages)
+    copyOnWrite = new bool[numPages];
+    for (i = 0; i < numPages; i++)
+        copyOnWrite[i] = FALSE;
+
+    // the pages holding nothing but code are never written, so all the
+    // processes running this executable can share them: the first one
+    // reads them in, the next ones map the same frames (see textcache.h)
+    unsigned int firstText = divRoundUp(noffH.code.virtualAddr, PageSize);
+    unsigned int endText = (noffH.code.virtualAddr + noffH.code.size) / PageSize;
+    if ((noffH.initData.size > 0) &&
+        (noffH.initData.virtualAddr < (int)(endText * PageSize)))
+        endText = noffH.initData.virtualAddr / PageSize;
+    if ((noffH.uninitData.size > 0) &&
+        (noffH.uninitData.virtualAddr < (int)(endText * PageSize)))
+        endText = noffH.uninitData.virtualAddr / PageSize;
+    if ((noffH.code.size <= 0) || (endText < firstText))
+        endText = firstText;
+    unsigned int numText = endText - firstText;
+    int *textFrames = new int[numText];
+    unsigned int numShared = 0;
+    if ((numText > 0) &&
+        textCache->Lookup(executable->HeaderSector(), &noffH.code,
+                          textFrames, numText))
+        numShared = numText;
+
+    if (frameProvider->NumAvailFrame() < numPages - numShared)
+        textCache->Trim(); // give back the code kept for the next runs
+    if (frameProvider->NumAvailFrame() < numPages - numShared)
 	{
         fprintf(stderr, "Error in addrSpace:  Not Enough frames to allocate.\n");
+		for (i = 0; i < numShared; i++)
+			frameProvider->ReleaseFrame(textFrames[i]) ;
+		delete[] textFrames ;
 		isSpaceCreated = false ;
 		return ; 
 	}
 
 
     for (i = 0; i < numPages; i++) {
+        pageTable[i].virtualPage = i; // for now, virtual page # = phys page #
+        pageTable[i].valid = TRUE;
+        pageTable[i].use = FALSE;
+        pageTable[i].dirty = FALSE;
+        pageTable[i].readOnly = FALSE; // until the code is loaded
+        if ((numShared > 0) && (i >= firstText) && (i < endText)) {
+            pageTable[i].physicalPage = textFrames[i - firstText];
+            pageTable[i].readOnly = TRUE;
+            continue;
+        }
 
         if (!frameProvider->IsFrameAvail()) {
 			fprintf(stderr, "Error in AddrrSpace: No more frame available. \n");
@@ -114,22 +188,30 @@ AddrSpace::AddrSpace(OpenFile *executable) {
 		}
 		
 		pageTable[i].physicalPage = frameProvider->GetEmptyFrame() ;
-        pageTable[i].virtualPage = i; // for now, virtual page # = phys page #
         // pageTable[i].physicalPage = i + 1;
-        pageTable[i].valid = TRUE;
-        pageTable[i].use = FALSE;
-        pageTable[i].dirty = FALSE;
-        pageTable[i].readOnly = FALSE; // if the code segment was entirely on
-                                       // a separate page, we could set its
-                                       // pages to be read-only
     }
 
     // zero out the entire address space, to zero the unitialized data segment
     // and the stack segment
     // bzero(machine->mainMemory, size);
 
-    // then, copy in the code and data segments into memory
-    if (noffH.code.size > 0) {
+    // then, copy in the code and data segments into memory; of the code
+    // already shared, only the ends on pages of their own are read
+    if ((noffH.code.size > 0) && (numShared > 0)) {
+		int start = noffH.code.virtualAddr, end = firstText * PageSize;
+		for (int part = 0; part < 2; part++) {
+			if (end > start) {
+				DEBUG ('a', "Initializing code segment part, at 0x%x, size %d\n",
+						start, end - start);
+				ReadAtVirtual(executable, start, end - start,
+						noffH.code.inFileAddr + start - noffH.code.virtualAddr,
+						pageTable, numPages) ;
+			}
+			start = endText * PageSize;
+			end = noffH.code.virtualAddr + noffH.code.size;
+		}
+		stats->numSharedCodePages += numShared;
+	} else if (noffH.code.size > 0) {
 		DEBUG ('a', "Initializing code segment, at 0x%x, size %d\n",
 				noffH.code.virtualAddr, noffH.code.size);
 		ReadAtVirtual(executable, noffH.code.virtualAddr, noffH.code.size, 
@@ -142,25 +224,122 @@ AddrSpace::AddrSpace(OpenFile *executable) {
 				noffH.initData.inFileAddr, pageTable, numPages);
 	}
 
+    // once loaded, the code is protected, and kept for the next processes
+    // running the executable
+    if ((numText > 0) && (numShared == 0)) {
+        for (i = firstText; i < endText; i++) {
+            pageTable[i].readOnly = TRUE;
+            textFrames[i - firstText] = pageTable[i].physicalPage;
+        }
+        textCache->Insert(executable->HeaderSector(), &noffH.code,
+                          textFrames, numText);
+    }
+    delete[] textFrames;
+
+#endif
+
     InitSpaceSetup();
 	isSpaceCreated = true ;
 }
 
+//----------------------------------------------------------------------
+// AddrSpace::AddrSpace
+//      Create an address space whose memory is already in place, when
+//      a snapshot is restored (see snapshot.cc).
+//
+//      "table" is the page table, allocated with new[]; the address
+//              space takes it over, along with the frames it maps
+//      "n" is the number of entries in "table"
+//----------------------------------------------------------------------
+
+AddrSpace::AddrSpace(TranslationEntry *table, unsigned int n) {
+    pageTable = table;
+    numPages = n;
+    copyOnWrite = new bool[numPages];
+    for (unsigned int i = 0; i < numPages; i++)
+        copyOnWrite[i] = FALSE;
+#ifdef DEMAND_PAGING
+    executableFile = NULL; // every page is already in memory
+    swapSlots = new int[numPages];
+    for (unsigned int i = 0; i < numPages; i++)
+        swapSlots[i] = -1;
+#endif
+
+    InitSpaceSetup();
+    isSpaceCreated = true;
+}
+
+#ifndef DEMAND_PAGING
+//----------------------------------------------------------------------
+// AddrSpace::AddrSpace
+//      Create a copy of an address space, for a fork, without copying
+//      any memory: the child maps the frames of the parent, and the
+//      pages both can write become read-only in both, until one of them
+//      writes to the page and gets its own copy (see CopyOnWrite).  So
+//      a fork costs a walk of the page table, not a copy of the image.
+//
+//      "parent" is the address space of the thread calling fork; it is
+//              the one loaded in the machine
+//----------------------------------------------------------------------
+
+AddrSpace::AddrSpace(AddrSpace *parent) {
+    handles = NULL; // until InitSpaceSetup
+
+    numPages = parent->numPages;
+    pageTable = new TranslationEntry[numPages];
+    copyOnWrite = new bool[numPages];
+    for (unsigned int i = 0; i < numPages; i++) {
+        pageTable[i] = parent->pageTable[i];
+        copyOnWrite[i] = parent->copyOnWrite[i];
+        if (!pageTable[i].valid)
+            continue;
+        frameProvider->ShareFrame(pageTable[i].physicalPage);
+        if (!pageTable[i].readOnly) {
+            pageTable[i].readOnly = parent->pageTable[i].readOnly = TRUE;
+            copyOnWrite[i] = parent->copyOnWrite[i] = TRUE;
+        }
+    }
+    machine->FlushTranslationCache(); // the parent may have cached
+    // its pages as writable
+    DEBUG('a', "Forked address space, num pages %d\n", numPages);
+
+    InitSpaceSetup();
+    isSpaceCreated = true;
+}
+#endif
+
 //----------------------------------------------------------------------
 // AddrSpace::~AddrSpace
 //      Dealloate an address space.  Nothing for now!
 //----------------------------------------------------------------------
 
 AddrSpace::~AddrSpace() {
+    // unload the page table, lest a later address space whose table
+    // gets the same address look loaded already
+    if (IsLoaded()) {
+#ifdef USE_TLB
+        tlbManager->Load(NULL);
+#else
+        machine->pageTable = NULL;
+        machine->pageTableSize = 0;
+        machine->FlushTranslationCache();
+#endif
+    }
     // LB: Missing [] for delete
 	FreeFrames();
     // delete pageTable;
     delete[] pageTable;
+    delete[] copyOnWrite;
 
     delete threadStackBitmap;
     delete threadTableLock;
     delete threadStackBitmapLock;
     delete threadExitCond;
+    delete handles;
+#ifdef DEMAND_PAGING
+    delete[] swapSlots;
+    delete executableFile;
+#endif
 
     DeleteJoinConditions();
     // delete[] threadWait;
@@ -202,12 +381,16 @@ void AddrSpace::InitRegisters() {
 //      On a context switch, save any machine state, specific
 //      to this address space, that needs saving.
 //
-//      For now, nothing!
+//      For now, nothing!  With a TLB, its entries are left in place:
+//      if the next user thread is in this address space too, they are
+//      still good.
 //----------------------------------------------------------------------
 
 void AddrSpace::SaveState() {
+#ifndef USE_TLB
     pageTable = machine->pageTable;
     numPages = machine->pageTableSize;
+#endif
 }
 
 //----------------------------------------------------------------------
@@ -215,12 +398,37 @@ void AddrSpace::SaveState() {
 //      On a context switch, restore the machine state so that
 //      this address space can run.
 //
-//      For now, tell the machine where to find the page table.
+//      For now, tell the machine where to find the page table, and
+//      drop the translations it cached for the previous one.  With a
+//      TLB, the machine never sees the page table: the TLB is flushed
+//      instead, if it holds the translations of another address space,
+//      and refilled from the page table on each miss.
 //----------------------------------------------------------------------
 
 void AddrSpace::RestoreState() {
+#ifdef USE_TLB
+    tlbManager->Load(this);
+#else
     machine->pageTable = pageTable;
     machine->pageTableSize = numPages;
+    machine->FlushTranslationCache();
+#endif
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::IsLoaded
+//      Return TRUE if the machine is already using the page table of
+//      this address space, so a context switch between two of its
+//      threads need not restore it (see Scheduler::Run).
+//----------------------------------------------------------------------
+
+bool AddrSpace::IsLoaded() {
+#ifdef USE_TLB
+    return tlbManager->IsLoaded(this);
+#else
+    return (machine->pageTable == pageTable) &&
+           (machine->pageTableSize == numPages);
+#endif
 }
 
 // INIT STRUCTURE PURPOSE
@@ -247,6 +455,7 @@ void AddrSpace::InitSpaceSetup(){
 	threadStackBitmapLock = new Lock("AddrSpace threads stack lock") ;
 	threadExitCond = new Condition("AddrSpace threads exit cond") ;
 	InitJoinConditions() ;
+	handles = new HandleTable() ;
 
 	nb_threads = 1 ;
     max_threads = UserThreadMax - 1;
@@ -397,6 +606,20 @@ void AddrSpace::RemoveStackPointer(int sp)
     threadStackBitmap->Clear(i);
 }
 
+// ----------------------------------------------------------------
+// 	AddrSpace::ClaimStackPointer
+//		Marks the stack slot of a given stack pointer as used
+//
+//		used by a fork, when the calling thread is a user thread: its
+//		copy in the child runs on the same stack, which must not be
+//		handed to a new thread of the child
+// -----------------------------------------------------------------
+void AddrSpace::ClaimStackPointer(int sp)
+{
+	int i = ((numPages*PageSize - sp) / UserThreadStackSize) - 1;
+    threadStackBitmap->Mark(i);
+}
+
 // ----------------------------------------------------------------
 // 	Public access to synchronization primitives
 //		Allows access to synchronization operation call without 
@@ -431,6 +654,7 @@ void AddrSpace::LockThreadStack(){ threadStackBitmapLock->Acquire() ; }
 
 void AddrSpace::UnlockThreadStack() { threadStackBitmapLock->Release() ; }
 
+#ifndef DEMAND_PAGING
 // -------------------------------------------------------------------------
 // 	ReadAtVirtual
 //		Reads data from an executable file into a specified virtual address
@@ -453,6 +677,7 @@ static void ReadAtVirtual(OpenFile *executable, int virtualaddr,
 
 	machine->pageTable = pageTable ;
 	machine->pageTableSize = numPages ;
+	machine->FlushTranslationCache() ;
 
 	for (i = 0 ; i < nbBytes ; i ++) 
 	{
@@ -461,7 +686,9 @@ static void ReadAtVirtual(OpenFile *executable, int virtualaddr,
 
 	machine->pageTable = oldTable ;
 	machine->pageTableSize = oldTableSize ;
+	machine->FlushTranslationCache() ;
 }
+#endif
 
 // ----------------------------------------------------------------
 // 	AddrSpace::FreeFrames
@@ -470,6 +697,9 @@ static void ReadAtVirtual(OpenFile *executable, int virtualaddr,
 // -----------------------------------------------------------------
 void AddrSpace::FreeFrames()
 {
+#ifdef DEMAND_PAGING
+	pager->ReleasePages(this) ; // also frees the swap slots
+#else
 	for (unsigned int i = 0 ; i < numPages ; i ++) 
 	{
 		if (pageTable[i].valid) 
@@ -477,7 +707,111 @@ void AddrSpace::FreeFrames()
 			frameProvider->ReleaseFrame(pageTable[i].physicalPage) ;
 		}
 	}
+#endif
+}
+
+// ----------------------------------------------------------------
+// 	AddrSpace::CopyOnWrite
+//		Gives a page shared by a fork a frame of its own, after a write
+//		to it raised a ReadOnlyException
+//
+//		If other address spaces still map the frame, its contents are
+//		copied to a new frame, and this address space drops the old one;
+//		if it was the last one, it keeps the frame. Either way the page
+//		becomes writable again, and the write can be retried.
+//
+//		Called with interrupts disabled. Getting a frame may wait for
+//		the lock of the frame provider, during which another thread of
+//		the address space may copy the page first
+//
+//		Arguments:
+//			virtAddr: the address that could not be written
+//
+//		Returns:
+//			true if the page is now writable, false if it is really
+//			read-only, or no frame is left for the copy
+// -----------------------------------------------------------------
+bool AddrSpace::CopyOnWrite(int virtAddr)
+{
+	unsigned int vpn = (unsigned) virtAddr / PageSize ;
+
+	if ((vpn >= numPages) || ! copyOnWrite[vpn]) return false ;
+
+	int oldFrame = pageTable[vpn].physicalPage ;
+	if (frameProvider->GetRefCount(oldFrame) > 1)
+	{
+		int frame = frameProvider->GetEmptyFrame() ;
+		if (frame < 0)
+		{
+			fprintf(stderr, "Error in CopyOnWrite: No more frame available. \n") ;
+			return false ;
+		}
+		if (! copyOnWrite[vpn]) // copied meanwhile
+		{
+			frameProvider->ReleaseFrame(frame) ;
+			return true ;
+		}
+		memcpy(&(machine->mainMemory[frame * PageSize]),
+				&(machine->mainMemory[oldFrame * PageSize]), PageSize) ;
+		pageTable[vpn].physicalPage = frame ;
+		frameProvider->ReleaseFrame(oldFrame) ;
+		stats->numCopiesOnWrite ++ ;
+	}
+	DEBUG('a', "Copy on write of page %d, in frame %d\n", vpn,
+			pageTable[vpn].physicalPage) ;
+
+	pageTable[vpn].readOnly = FALSE ;
+	copyOnWrite[vpn] = false ;
+	machine->FlushTranslationCache() ; // the old frame may be cached
+	return true ;
+}
+
+#ifdef DEMAND_PAGING
+// -------------------------------------------------------------------------
+// 	ReadSegmentPart
+//		Reads the part of a segment of the executable that falls in a page
+//
+//		Arguments:
+//			executable: the file holding the segment
+//			segment: where the segment is, in the file and in memory
+//			pageStart: the virtual address of the page
+//			into: the contents of the page
+// -------------------------------------------------------------------------
+
+static void ReadSegmentPart(OpenFile *executable, Segment *segment,
+		int pageStart, char *into)
+{
+	int from = segment->virtualAddr ;
+	int to = segment->virtualAddr + segment->size ;
+
+	if (from < pageStart) from = pageStart ;
+	if (to > pageStart + PageSize) to = pageStart + PageSize ;
+	if (from >= to) return ;
+	executable->ReadAt(into + (from - pageStart), to - from,
+			segment->inFileAddr + (from - segment->virtualAddr)) ;
+}
+
+// ----------------------------------------------------------------
+// 	AddrSpace::ReadPage
+//		Fills a frame with the initial contents of a page that was
+//		never evicted: the code and initialized data it holds, read
+//		from the executable, and zeroes everywhere else (uninitialized
+//		data, stack)
+//
+//		Arguments:
+//			vpn: the virtual page number
+//			into: the frame, in main memory
+// -----------------------------------------------------------------
+void AddrSpace::ReadPage(unsigned int vpn, char *into)
+{
+	int pageStart = vpn * PageSize ;
+
+	bzero(into, PageSize) ;
+	if (executableFile == NULL) return ;
+	ReadSegmentPart(executableFile, &codeSegment, pageStart, into) ;
+	ReadSegmentPart(executableFile, &initDataSegment, pageStart, into) ;
 }
+#endif
 
 // ----------------------------------------------------------------
 // 	AddrSpace::IsCreated
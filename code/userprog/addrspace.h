@@ -15,7 +15,11 @@
 
 #include "copyright.h"
 #include "filesys.h"
+#include "handletable.h"
 #include "translate.h"
+#ifdef DEMAND_PAGING
+#include "noff.h"
+#endif
 
 #define UserStackSize 1048 // increase this as necessary!
 
@@ -30,6 +34,14 @@ class AddrSpace {
     AddrSpace(OpenFile *executable); // Create an address space,
     // initializing it with the program
     // stored in the file "executable"
+    AddrSpace(TranslationEntry *table, unsigned int n);
+    // Create an address space from a
+    // page table restored from a snapshot
+#ifndef DEMAND_PAGING
+    AddrSpace(AddrSpace *parent); // Create a copy of "parent", for a
+    // fork: the pages are shared, and
+    // copied on write
+#endif
     ~AddrSpace(); // De-allocate an address space
 
     void InitRegisters(); // Initialize user-level CPU registers,
@@ -37,12 +49,16 @@ class AddrSpace {
 
     void SaveState();    // Save/restore address space-specific
     void RestoreState(); // info on a context switch
+    bool IsLoaded();     // Is this the page table in the machine?
 
     int GetNumThreads();
     unsigned int GetNextThreadID();
 		bool IsCreated() ;
+    TranslationEntry *GetPageTable() { return pageTable; }
+    unsigned int GetNumPages() { return numPages; }
     int processID;
     unsigned int max_threads;
+    HandleTable *handles; // kernel objects of the process, by handle
 
     /* Resource management */
     /* Methods for Thread Table management */
@@ -57,6 +73,7 @@ class AddrSpace {
 		void UnlockThreadStack() ;
 		int GetStackPointer() ;
 		void RemoveStackPointer(int i) ;
+		void ClaimStackPointer(int sp) ;
 
     /* Synch management */
     /* Methods for waiting a thread */
@@ -71,6 +88,14 @@ class AddrSpace {
 
     /* Methods for frame management */
     void FreeFrames() ;
+    bool CopyOnWrite(int virtAddr) ; // Give the page a frame of its own, after a write to a page shared by a fork
+
+#ifdef DEMAND_PAGING
+    /* Methods for demand paging (see vm/pager.h) */
+    void ReadPage(unsigned int vpn, char *into); // Initial contents of a page
+    int GetSwapSlot(unsigned int vpn) { return swapSlots[vpn]; }
+    void SetSwapSlot(unsigned int vpn, int slot) { swapSlots[vpn] = slot; }
+#endif
 
     /* Init function */
     void InitSpaceSetup();
@@ -88,6 +113,14 @@ class AddrSpace {
     Condition *threadExitCond;              // condition variable used to manage synchronization when threads exit
     unsigned int* threadTable;              // arrray that stores the IDs of the thread currently active in the address space
     Condition** threadSynchTable;           // array of condition variable for thread synchronization, mainly used for coordination and wait
+    bool *copyOnWrite;                      // for each page, whether it is read-only only until written, because a fork shares its frame
+
+#ifdef DEMAND_PAGING
+    OpenFile *executableFile;               // where code and initialized data are read from, NULL if none
+    Segment codeSegment;                    // ... and where they are, in the file and in the address space
+    Segment initDataSegment;
+    int *swapSlots;                         // swap slot of each page, -1 if it has never been evicted
+#endif
 
 };
 
@@ -26,6 +26,8 @@
 #include "system.h"
 #include "userthread.h"
 #include "userSem.h"
+#include "userSynch.h"
+#include "futex.h"
 #include "userprocess.h"
 #include "filesys.h"
 
@@ -70,12 +72,22 @@ int arg1;
 int arg2;
 int arg3;
 int arg4;
-Semaphore *tmp;
 
 
 void ExceptionHandler(ExceptionType which) {
     IntStatus oldLevel = interrupt->SetLevel(IntOff);
 
+#ifdef USE_TLB
+    // the fast path: a TLB miss on a page in memory only needs the TLB
+    // refilled, then the faulting access is retried
+    if ((which == PageFaultException) &&
+        tlbManager->Refill(currentThread->space,
+                           machine->ReadRegister(BadVAddrReg))) {
+        (void)interrupt->SetLevel(oldLevel);
+        return;
+    }
+#endif
+
     type = machine->ReadRegister(2);
     arg1 = machine->ReadRegister(4);
     arg2 = machine->ReadRegister(5);
@@ -144,6 +156,13 @@ void ExceptionHandler(ExceptionType which) {
             }
             case SC_ThreadExit:
                 DEBUG('a', "Termination of a user thread, initiated by user program.\n");
+                if (currentThread->GetThreadID() == 1) {
+                    // the main thread -- in a child forked by a user
+                    // thread, the copy of that thread: the process ends
+                    // with it, once its other threads are done
+                    do_UserProcessExit();
+                    break;
+                }
                 do_UserThreadExit();
                 break;
 
@@ -154,18 +173,58 @@ void ExceptionHandler(ExceptionType which) {
 
             case SC_SemInit:
                 DEBUG('a', "Creating a new user semaphore.\n");
-                tmp = SemInit(arg1);
-                machine->WriteRegister(2, (int) tmp);
+                machine->WriteRegister(2, SemInit(arg1));
                 break;
 
             case SC_SemP:
                 DEBUG('a', "UserSem->P().\n");
-                SemP((Semaphore *)arg1);
+                machine->WriteRegister(2, SemP(arg1));
                 break;
 
             case SC_SemV:
                 DEBUG('a', "UserSem->V().\n");
-                SemV((Semaphore *)arg1);
+                machine->WriteRegister(2, SemV(arg1));
+                break;
+
+            case SC_SemDestroy:
+                DEBUG('a', "Destroying a user semaphore.\n");
+                machine->WriteRegister(2, SemDestroy(arg1));
+                break;
+
+            case SC_RWLockCreate:
+                DEBUG('a', "Creating a new user reader-writer lock.\n");
+                machine->WriteRegister(2, RWLockCreate(arg1));
+                break;
+
+            case SC_RWLockAcquireRead:
+                machine->WriteRegister(2, RWLockAcquireRead(arg1));
+                break;
+
+            case SC_RWLockAcquireWrite:
+                machine->WriteRegister(2, RWLockAcquireWrite(arg1));
+                break;
+
+            case SC_RWLockRelease:
+                machine->WriteRegister(2, RWLockRelease(arg1));
+                break;
+
+            case SC_RWLockDestroy:
+                DEBUG('a', "Destroying a user reader-writer lock.\n");
+                machine->WriteRegister(2, RWLockDestroy(arg1));
+                break;
+
+            case SC_BarrierCreate:
+                DEBUG('a', "Creating a new user barrier.\n");
+                machine->WriteRegister(2, BarrierCreate(arg1));
+                break;
+
+            case SC_BarrierWait:
+                machine->WriteRegister(2, BarrierWait(arg1));
+                break;
+
+            case SC_BarrierDestroy:
+                DEBUG('a', "Destroying a user barrier.\n");
+                machine->WriteRegister(2, BarrierDestroy(arg1));
                 break;
 
             case SC_Exit:
@@ -186,6 +245,12 @@ void ExceptionHandler(ExceptionType which) {
                 break;
             }
 
+            case SC_Fork: {
+                int res = do_UserProcessFork();
+                machine->WriteRegister(2, res);
+                break;
+            }
+
             case SC_WaitProcess: {
                 if(arg1 > TEMP_MAXPROC_NUMBER || arg1 < 0 || arg1 == currentThread->space->processID){
                     fprintf(stderr, "Error in Exception: Got a wrong process ID in WaitProcess: %d and current: %d\n", arg1, currentThread->space->processID);
@@ -201,6 +266,18 @@ void ExceptionHandler(ExceptionType which) {
                 machine->WriteRegister(2, currentThread->space->processID);
                 break;
 
+            case SC_GetTicks:
+                machine->WriteRegister(2, (int)stats->totalTicks);
+                break;
+
+            case SC_FutexWait:
+                machine->WriteRegister(2, do_FutexWait(arg1, arg2));
+                break;
+
+            case SC_FutexWake:
+                machine->WriteRegister(2, do_FutexWake(arg1, arg2));
+                break;
+
             case SC_Create: 
                 char filename[MAX_FILENAME];
                 copyStringFromMachine(arg1, filename, MAX_FILENAME);
@@ -246,7 +323,28 @@ void ExceptionHandler(ExceptionType which) {
                 arg4++;
                 break;
         }
+    }  else if( which == ReadOnlyException){
+        // a write to a page a fork shares: once it has its own copy, run
+        // the faulting instruction again (so the PC must not move)
+        if (currentThread->space->CopyOnWrite(machine->ReadRegister(BadVAddrReg))) {
+            (void)interrupt->SetLevel(oldLevel);
+            return;
+        }
+        fprintf(stderr, "Error in Exception: Write to a read-only page. \n");
     }  else if( which == PageFaultException){
+#ifdef DEMAND_PAGING
+        // a page not brought in yet: once it is, run the faulting
+        // instruction again (so the PC must not move)
+        if (pager->PageFault(currentThread->space,
+                             machine->ReadRegister(BadVAddrReg))) {
+#ifdef USE_TLB
+            (void)tlbManager->Refill(currentThread->space,
+                                     machine->ReadRegister(BadVAddrReg));
+#endif
+            (void)interrupt->SetLevel(oldLevel);
+            return;
+        }
+#endif
         fprintf(stderr, "Error in Exception: Page Fault Error. \n");
     }
      (void)interrupt->SetLevel(oldLevel);
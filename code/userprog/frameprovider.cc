@@ -12,7 +12,9 @@
 //
 //			This constructor creates and initiliazes a bitmap 'frameBitmap' 
 //			to track the availability of each physical frames. It sets the
-//			initial total number of frames and a lock 'frameBitmapLock'
+//			initial total number of frames and a reader-writer lock
+//			'frameBitmapLock', so that queries about the frames do not
+//			serialize each other, and the reference counts of the frames
 //
 //			'numFrames' represents the number of physical frames available
 //---------------------------------------------------------------------------
@@ -22,9 +24,18 @@ FrameProvider::FrameProvider(int numFrames)
 	srand(time(NULL)) ;
 
 	framesBitmap = new BitMap(numFrames) ;
-	framesBitmap->Mark(0) ;
+	refCounts = new int[numFrames] ;
+	for (int i = 0 ; i < numFrames ; i ++)
+	{
+		refCounts[i] = 0 ;
+	}
+	for (int i = 0 ; i < NumReservedFrames ; i ++)
+	{
+		framesBitmap->Mark(i) ;
+		refCounts[i] = 1 ;
+	}
 
-	framesBitmapLock = new Lock("FrameProvider bitmap lock") ;
+	framesBitmapLock = new RWLock("FrameProvider bitmap lock", WriterPreference) ;
 	nb_frames = numFrames ;
 }
 
@@ -38,6 +49,7 @@ FrameProvider::FrameProvider(int numFrames)
 FrameProvider::~FrameProvider()
 {
 	delete framesBitmap ;
+	delete[] refCounts ;
 	delete framesBitmapLock ;
 }
 
@@ -62,7 +74,7 @@ int FrameProvider::GetEmptyFrame()
 {
 	int selectedFrame = -1;
 
-	framesBitmapLock->Acquire() ;
+	framesBitmapLock->AcquireWrite() ;
 
 	int emptyFramesCount = 0;
 	for (int i = 0 ; i < nb_frames ; i ++)
@@ -77,33 +89,83 @@ int FrameProvider::GetEmptyFrame()
 	}
 
 	if(selectedFrame == -1){
-		framesBitmapLock->Release();
+		framesBitmapLock->ReleaseWrite();
 		return -1;
 	}
 	
 	framesBitmap->Mark(selectedFrame) ;
+	refCounts[selectedFrame] = 1 ;
 	bzero(&(machine->mainMemory[selectedFrame * PageSize]), PageSize) ;
-	framesBitmapLock->Release() ;
+	machine->InvalidateDecodedFrame(selectedFrame) ;
+	framesBitmapLock->ReleaseWrite() ;
 
 	return selectedFrame ;
 }
 
 //--------------------------------------------------------------------------
 // FrameProvider::ReleaseFrame
-//			Mark a given frame as available.
+//			Drop one user of a given frame, and mark it as available when
+//			it was the last one.
 //
-//			This function clears the status of a specific frame in the bitmap
-//			for future allocations.
+//			A frame shared by several address spaces after a fork (see
+//			ShareFrame) stays allocated until all of them have released
+//			it; otherwise, this function clears the status of the frame in
+//			the bitmap for future allocations.
 //
 //			arg:
-//				frame: the index of the frame to mark
+//				frame: the index of the frame to release
 //---------------------------------------------------------------------------
 
 void FrameProvider::ReleaseFrame(int frame)
 {
-	framesBitmapLock->Acquire() ;
-	framesBitmap->Clear(frame) ;
-	framesBitmapLock->Release() ;
+	framesBitmapLock->AcquireWrite() ;
+	ASSERT(refCounts[frame] > 0) ;
+	if (-- refCounts[frame] == 0)
+	{
+		framesBitmap->Clear(frame) ;
+	}
+	framesBitmapLock->ReleaseWrite() ;
+}
+
+//--------------------------------------------------------------------------
+// FrameProvider::ShareFrame
+//			Add a user to an allocated frame.
+//
+//			This is used when a fork maps the frames of the parent in the
+//			child: each address space releases the frame in turn, and it
+//			is only freed after the last one.
+//
+//			arg:
+//				frame: the index of the frame, which must be allocated
+//---------------------------------------------------------------------------
+
+void FrameProvider::ShareFrame(int frame)
+{
+	framesBitmapLock->AcquireWrite() ;
+	ASSERT(framesBitmap->Test(frame)) ;
+	refCounts[frame] ++ ;
+	framesBitmapLock->ReleaseWrite() ;
+}
+
+//--------------------------------------------------------------------------
+// FrameProvider::GetRefCount
+//			Return the number of users of a given frame.
+//
+//			arg:
+//				frame: the index of the frame
+//
+//			return:
+//				the number of page table entries mapping the frame, 0 if
+//				it is free
+//---------------------------------------------------------------------------
+
+int FrameProvider::GetRefCount(int frame)
+{
+	framesBitmapLock->AcquireRead() ;
+	int count = refCounts[frame] ;
+	framesBitmapLock->ReleaseRead() ;
+
+	return count ;
 }
 
 //--------------------------------------------------------------------------
@@ -119,9 +181,9 @@ void FrameProvider::ReleaseFrame(int frame)
 
 unsigned int FrameProvider::NumAvailFrame()
 {
-	framesBitmapLock->Acquire() ;
+	framesBitmapLock->AcquireRead() ;
 	int numFrames = framesBitmap->NumClear();
-	framesBitmapLock->Release() ;
+	framesBitmapLock->ReleaseRead() ;
 
     return numFrames;
 }
@@ -141,3 +203,57 @@ bool FrameProvider::IsFrameAvail()
 {
 	return NumAvailFrame() > 0 ;
 }
+
+//--------------------------------------------------------------------------
+// FrameProvider::IsFrameUsed
+//			Checks whether a given frame is allocated.
+//
+//			arg:
+//				frame: the index of the frame to check
+//
+//			return:
+//				true if the frame is in use, false otherwise
+//---------------------------------------------------------------------------
+
+bool FrameProvider::IsFrameUsed(int frame)
+{
+	framesBitmapLock->AcquireRead() ;
+	bool used = framesBitmap->Test(frame) ;
+	framesBitmapLock->ReleaseRead() ;
+
+	return used ;
+}
+
+//--------------------------------------------------------------------------
+// FrameProvider::ClaimFrame
+//			Allocate a given frame of physical memory, rather than one
+//			chosen by the provider.
+//
+//			This is used when restoring a snapshot, whose page tables
+//			refer to the frames that were allocated when it was taken.
+//			Unlike GetEmptyFrame, the frame is not cleared: its contents
+//			are about to be restored.
+//
+//			arg:
+//				frame: the index of the frame to allocate
+//
+//			return:
+//				true if the frame was free and is now allocated, false
+//				if it was already in use
+//---------------------------------------------------------------------------
+
+bool FrameProvider::ClaimFrame(int frame)
+{
+	framesBitmapLock->AcquireWrite() ;
+
+	if (framesBitmap->Test(frame))
+	{
+		framesBitmapLock->ReleaseWrite() ;
+		return false ;
+	}
+	framesBitmap->Mark(frame) ;
+	refCounts[frame] = 1 ;
+
+	framesBitmapLock->ReleaseWrite() ;
+	return true ;
+}
@@ -5,6 +5,8 @@
 #include "bitmap.h"
 #include "synch.h"
 
+#define NumReservedFrames 1					// frames allocated at boot, from frame 0, never given to a process
+
 
 class FrameProvider 
 {
@@ -14,15 +16,21 @@ class FrameProvider
 		~FrameProvider() ;					// cleans up resources used by the frameprovider
 
 		int GetEmptyFrame() ;				// allocates and returns an empty frame
-		void ReleaseFrame(int frame) ;		// marks a given frame as free
+		void ReleaseFrame(int frame) ;		// drops a user of a given frame, and marks it as free once it has none
+		void ShareFrame(int frame) ;		// adds a user to an allocated frame
+		int GetRefCount(int frame) ;		// returns the number of users of a given frame
 		unsigned int NumAvailFrame() ;		// returns the number of available frames
 		bool IsFrameAvail() ;				// checks if at least one frame is available
+		bool IsFrameUsed(int frame) ;		// checks whether a given frame is allocated
+		bool ClaimFrame(int frame) ;		// allocates a given frame, if it is free
 
 	private :
 
 		int nb_frames ;					// total number of frames managed by the provider
 		BitMap *framesBitmap ;				// bitmap to tracks the status of whether user or available of each frame
-		Lock *framesBitmapLock ;  			// lock to synchronise access to the bitmap
+		int *refCounts ;					// number of page table entries mapping each frame (address spaces sharing it after a fork)
+		RWLock *framesBitmapLock ;  		// lock to synchronise access to the bitmap:
+											// queries share it, allocations take it
 } ;
 
 
@@ -0,0 +1,123 @@
+// futex.cc
+//      Routines to block user threads on words of user memory, and wake
+//      them up.  See futex.h.
+//
+//      The sleeping threads are kept in a hash table of FutexBuckets
+//      lists, keyed by address space and address.  The list elements
+//      live on the kernel stacks of the sleeping threads.
+//
+//      Both routines run with interrupts off (as ExceptionHandler does
+//      anyway), so checking the word and going to sleep is atomic with
+//      respect to other threads.
+
+#include "copyright.h"
+#include "futex.h"
+#include "system.h"
+
+#define FutexBuckets 64
+
+// A thread sleeping on a word.
+
+class FutexWaiter {
+  public:
+    AddrSpace *space; // where "addr" is
+    int addr;         // the word slept on
+    Thread *thread;
+    FutexWaiter *next; // next waiter in the same bucket, in the order
+    // they went to sleep
+};
+
+static FutexWaiter *buckets[FutexBuckets]; // all NULL to start with
+
+//----------------------------------------------------------------------
+// BucketFor
+//      Return the list of the threads that may be sleeping on a word.
+//----------------------------------------------------------------------
+
+static FutexWaiter **BucketFor(AddrSpace *space, int addr) {
+    return &buckets[((unsigned)addr / 4 + (unsigned)space->processID * 31) %
+                    FutexBuckets];
+}
+
+//----------------------------------------------------------------------
+// do_FutexWait
+//      Put the current thread to sleep on a word of its address space,
+//      provided the word still holds the value the caller saw: if it
+//      changed, the thread it waited for has already been and gone, and
+//      sleeping would miss its FutexWake.
+//
+//      "addr" -- the virtual address of the word
+//      "value" -- what the caller expects it to hold
+//
+// Returns:
+//      0 once woken up by do_FutexWake, 1 if the word did not hold
+//      "value", -1 if "addr" is not an aligned word of the address space
+//----------------------------------------------------------------------
+
+int do_FutexWait(int addr, int value) {
+    AddrSpace *space = currentThread->space;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    FutexWaiter waiter, **last;
+    int current;
+
+    if ((addr & 0x3) ||
+        ((unsigned)addr >= space->GetNumPages() * PageSize) ||
+        !machine->ReadMem(addr, 4, &current)) {
+        (void)interrupt->SetLevel(oldLevel);
+        return -1;
+    }
+    if (current != value) {
+        (void)interrupt->SetLevel(oldLevel);
+        return 1;
+    }
+
+    DEBUG('a', "Thread \"%s\" sleeps on futex 0x%x\n",
+          currentThread->getName(), addr);
+    waiter.space = space;
+    waiter.addr = addr;
+    waiter.thread = currentThread;
+    waiter.next = NULL;
+    for (last = BucketFor(space, addr); *last != NULL; last = &(*last)->next)
+        ;
+    *last = &waiter;
+    currentThread->Sleep(); // until do_FutexWake unlinks "waiter"
+
+    (void)interrupt->SetLevel(oldLevel);
+    return 0;
+}
+
+//----------------------------------------------------------------------
+// do_FutexWake
+//      Wake up threads of the current address space sleeping on a word,
+//      the first to have gone to sleep first.
+//
+//      "addr" -- the virtual address of the word
+//      "count" -- the most threads to wake up
+//
+// Returns:
+//      The number of threads woken up.
+//----------------------------------------------------------------------
+
+int do_FutexWake(int addr, int count) {
+    AddrSpace *space = currentThread->space;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    FutexWaiter **link = BucketFor(space, addr);
+    int woken = 0;
+
+    while ((*link != NULL) && (woken < count)) {
+        FutexWaiter *waiter = *link;
+
+        if ((waiter->space != space) || (waiter->addr != addr)) {
+            link = &waiter->next;
+            continue;
+        }
+        *link = waiter->next;
+        DEBUG('a', "Waking thread \"%s\" on futex 0x%x\n",
+              waiter->thread->getName(), addr);
+        scheduler->ReadyToRun(waiter->thread);
+        woken++;
+    }
+
+    (void)interrupt->SetLevel(oldLevel);
+    return woken;
+}
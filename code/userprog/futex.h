@@ -0,0 +1,30 @@
+// futex.h
+//      System calls to block user threads on a word of their own memory
+//      ("fast user-space mutexes", as in Linux).
+//
+//      User-level locks keep their state in a word of user memory, and
+//      change it with atomic instructions (LL/SC), without entering the
+//      kernel.  Only when a thread has to wait does it call FutexWait,
+//      which puts it to sleep on that word -- unless the word has changed
+//      in the meantime -- and only when there may be waiters does the
+//      thread releasing the lock call FutexWake.  See test/usync.h for
+//      the mutexes and condition variables built on these.
+//
+//      Waiting threads are identified by their address space and the
+//      virtual address of the word; no state is kept for a word nobody
+//      waits on.
+
+#ifndef FUTEX_H
+#define FUTEX_H
+
+#include "copyright.h"
+
+extern int do_FutexWait(int addr, int value); // Sleep until woken on
+// "addr", if it holds "value"; returns 0
+// once woken, 1 if it did not hold "value",
+// -1 if "addr" is not a valid word
+extern int do_FutexWake(int addr, int count); // Wake up to "count"
+// threads sleeping on "addr", in the order
+// they went to sleep; returns how many
+
+#endif // FUTEX_H
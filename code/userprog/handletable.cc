@@ -0,0 +1,159 @@
+// handletable.cc
+//      Routines to manage the handles of a process on kernel objects.
+//      See handletable.h.
+//
+//      The routines run with interrupts off, so a thread cannot be
+//      switched out in the middle of an update.
+
+#include "copyright.h"
+#include "handletable.h"
+#include "synch.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// HandleTable::HandleTable
+//      Initialize an empty table: all the entries are free.
+//----------------------------------------------------------------------
+
+HandleTable::HandleTable() {
+    for (int i = 0; i < MaxHandles; i++) {
+        entries[i].type = FreeHandle;
+        entries[i].generation = 1;
+        entries[i].object = NULL;
+        entries[i].nextFree = (i + 1 < MaxHandles) ? i + 1 : -1;
+    }
+    firstFree = 0;
+}
+
+//----------------------------------------------------------------------
+// HandleTable::~HandleTable
+//      Destroy the objects the process did not destroy itself.
+//----------------------------------------------------------------------
+
+HandleTable::~HandleTable() { DestroyAll(); }
+
+//----------------------------------------------------------------------
+// HandleTable::Add
+//      Take a free entry for an object, and return a handle on it.
+//
+//      "type" -- the kind of object
+//      "object" -- the object, which now belongs to the table
+//----------------------------------------------------------------------
+
+int HandleTable::Add(HandleType type, void *object) {
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int index = firstFree;
+
+    ASSERT(type != FreeHandle);
+    if (index < 0) {
+        (void)interrupt->SetLevel(oldLevel);
+        return -1;
+    }
+    firstFree = entries[index].nextFree;
+    entries[index].type = type;
+    entries[index].object = object;
+    (void)interrupt->SetLevel(oldLevel);
+    return (entries[index].generation << HandleIndexBits) | index;
+}
+
+//----------------------------------------------------------------------
+// HandleTable::IndexOf
+//      Return the entry of a handle, provided the entry holds an object
+//      of the right type, and was not freed since the handle was given.
+//----------------------------------------------------------------------
+
+int HandleTable::IndexOf(int handle, HandleType type) {
+    int index = handle & ((1 << HandleIndexBits) - 1);
+
+    if ((handle <= 0) || (index >= MaxHandles) ||
+        (entries[index].type != type) ||
+        (entries[index].generation != (handle >> HandleIndexBits)))
+        return -1;
+    return index;
+}
+
+//----------------------------------------------------------------------
+// HandleTable::Get
+//      Return the object of a handle.
+//
+//      "handle" -- as given by the user program
+//      "type" -- the kind of object the user program wants
+//----------------------------------------------------------------------
+
+void *HandleTable::Get(int handle, HandleType type) {
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int index = IndexOf(handle, type);
+    void *object = (index < 0) ? NULL : entries[index].object;
+
+    (void)interrupt->SetLevel(oldLevel);
+    return object;
+}
+
+//----------------------------------------------------------------------
+// HandleTable::Remove
+//      Free a handle, and return its object, which the caller is now
+//      responsible for.
+//----------------------------------------------------------------------
+
+void *HandleTable::Remove(int handle, HandleType type) {
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int index = IndexOf(handle, type);
+    void *object = NULL;
+
+    if (index >= 0) {
+        object = entries[index].object;
+        Free(index);
+    }
+    (void)interrupt->SetLevel(oldLevel);
+    return object;
+}
+
+//----------------------------------------------------------------------
+// HandleTable::Free
+//      Put an entry back on the free list, with a new generation so that
+//      the handles given for it so far are stale.
+//----------------------------------------------------------------------
+
+void HandleTable::Free(int index) {
+    HandleEntry *entry = &entries[index];
+
+    entry->type = FreeHandle;
+    entry->object = NULL;
+    if (++entry->generation == HandleGenerations)
+        entry->generation = 1; // never 0: a handle is always positive
+    entry->nextFree = firstFree;
+    firstFree = index;
+}
+
+//----------------------------------------------------------------------
+// HandleTable::DestroyAll
+//      Destroy every object in the table, as when the process exits.
+//----------------------------------------------------------------------
+
+void HandleTable::DestroyAll() {
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    for (int i = 0; i < MaxHandles; i++) {
+        switch (entries[i].type) {
+        case FreeHandle:
+            continue;
+        case SemaphoreHandle:
+            delete (Semaphore *)entries[i].object;
+            break;
+        case LockHandle:
+            delete (Lock *)entries[i].object;
+            break;
+        case ConditionHandle:
+            delete (Condition *)entries[i].object;
+            break;
+        case RWLockHandle:
+            delete (RWLock *)entries[i].object;
+            break;
+        case BarrierHandle:
+            delete (Barrier *)entries[i].object;
+            break;
+        }
+        Free(i);
+    }
+    (void)interrupt->SetLevel(oldLevel);
+}
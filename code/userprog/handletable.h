@@ -0,0 +1,72 @@
+// handletable.h
+//      Data structures to give user programs handles on kernel objects
+//      (semaphores, locks, condition variables, ...) instead of host
+//      pointers.
+//
+//      Each process has its own table, and a handle is only good in the
+//      process that created it.  A handle holds the index of its entry
+//      in the table and the generation of the entry: every time an entry
+//      is freed, its generation changes, so a handle to a destroyed
+//      object -- even if the entry was reused since -- is recognized as
+//      stale instead of reaching another object.  A handle is never 0
+//      or negative, so -1 can mean "no handle".
+//
+//      Looking up, adding and removing an object all take constant time.
+//      The objects left in a table are destroyed along with it, when the
+//      process exits.
+
+#ifndef HANDLETABLE_H
+#define HANDLETABLE_H
+
+#include "copyright.h"
+
+#define MaxHandles 64      // objects a process can have at once
+#define HandleIndexBits 6  // enough bits for an index below MaxHandles
+#define HandleGenerations (1 << (31 - HandleIndexBits)) // before they wrap
+
+// The kinds of objects a handle can designate; a handle is only good
+// for its own kind.
+enum HandleType {
+    FreeHandle,      // entry not in use
+    SemaphoreHandle, // Semaphore
+    LockHandle,      // Lock
+    ConditionHandle, // Condition
+    RWLockHandle,    // RWLock
+    BarrierHandle    // Barrier
+};
+
+// The following class defines a table of the kernel objects of one
+// process.
+
+class HandleTable {
+  public:
+    HandleTable();  // Initialize an empty table
+    ~HandleTable(); // Destroy the objects left, and the table
+
+    int Add(HandleType type, void *object); // Return a new handle on
+    // "object", or -1 if the table is full
+    void *Get(int handle, HandleType type); // The object of "handle",
+    // or NULL if it is not a live handle of that type
+    void *Remove(int handle, HandleType type); // The same, and free the
+    // handle: the caller destroys the object
+
+    void DestroyAll(); // Destroy all the objects, and free all handles
+
+  private:
+    class HandleEntry {
+      public:
+        HandleType type;
+        int generation; // from 1 to HandleGenerations - 1
+        void *object;
+        int nextFree; // next free entry if free, -1 if last
+    };
+
+    int IndexOf(int handle, HandleType type); // Entry of a live handle,
+    // or -1
+    void Free(int index); // Put an entry back on the free list
+
+    HandleEntry entries[MaxHandles];
+    int firstFree; // free entries, linked through nextFree; -1 if none
+};
+
+#endif // HANDLETABLE_H
@@ -14,6 +14,7 @@
 #include "synch.h"
 #include "system.h"
 #include "synchconsole.h"
+#include "snapshot.h"
 
 //----------------------------------------------------------------------
 // StartProcess
@@ -21,7 +22,21 @@
 //      memory, and jump to it.
 //----------------------------------------------------------------------
 
-void StartProcess(char *filename) {
+void SnapshotProcess(char *filename, char *snapshotName);
+
+void StartProcess(char *filename) { SnapshotProcess(filename, NULL); }
+
+//----------------------------------------------------------------------
+// SnapshotProcess
+//      Like StartProcess, but once the program is loaded, save a
+//      snapshot of the machine that a later run can start from (see
+//      snapshot.h), then jump to it.
+//
+//      "snapshotName" is the host file for the snapshot, or NULL for
+//              no snapshot
+//----------------------------------------------------------------------
+
+void SnapshotProcess(char *filename, char *snapshotName) {
     OpenFile *executable = fileSystem->Open(filename);
     AddrSpace *space;
 
@@ -32,11 +47,17 @@ void StartProcess(char *filename) {
     space = new AddrSpace(executable);
     currentThread->space = space;
 
-    delete executable; // close file
+#ifndef DEMAND_PAGING
+    delete executable; // close file (with demand paging, the address
+                       // space keeps it open, to load pages from)
+#endif
 
     space->InitRegisters(); // set the initial register values
     space->RestoreState();  // load page table register
 
+    if (snapshotName != NULL)
+        SaveSnapshot(snapshotName);
+
     machine->Run(); // jump to the user progam
     ASSERT(FALSE);  // machine->Run never returns;
     // the address space exits
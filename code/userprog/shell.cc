@@ -35,6 +35,7 @@ The default shell lunching if there's no user program choosen to execute
 */
 void shell(SynchConsole *c){
     console = c;
+    currentThread->setPriority(NumPriorities - 1); // interactive: with "-sched prio", runs before the programs it starts
     char prompt[3];
     prompt[0] = '~';
     prompt[1] = '~';
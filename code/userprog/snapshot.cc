@@ -0,0 +1,183 @@
+// snapshot.cc
+//      Routines to save the state of the machine and the initial user
+//      program to a host file, and to restore it in a later run.
+//
+//      The file holds, in order:
+//
+//              a SnapshotHeader (clock, registers, process table, which
+//                      frames were allocated, pending interrupts)
+//              the page table of the program, "numPages" entries
+//              the whole of main memory
+
+#include "copyright.h"
+#include "snapshot.h"
+#include "addrspace.h"
+#include "system.h"
+
+#define SnapshotMagic 0x534e4150 // "SNAP"
+#define MaxSnapshotInterrupts 16 // pending interrupts we keep track of
+
+// The fixed-size part of a snapshot.
+
+class SnapshotHeader {
+  public:
+    int magic;       // SnapshotMagic, to detect garbage
+    int memorySize;  // MemorySize when the snapshot was taken
+    int numPages;    // size of the page table
+    int processID;   // of the address space
+    int numPending;  // pending interrupts recorded
+
+    long long totalTicks; // the simulated clock, see stats.h
+    long long idleTicks;
+    long long systemTicks;
+    long long userTicks;
+
+    int registers[NumTotalRegs];            // user-level CPU registers
+    int processTable[TEMP_MAXPROC_NUMBER]; // see system.h
+    unsigned int numProcess;
+    char frameUsed[NumPhysPages];           // the FrameProvider bitmap
+
+    IntType pendingTypes[MaxSnapshotInterrupts]; // see
+    long long pendingWhens[MaxSnapshotInterrupts]; // Interrupt::SavePending
+};
+
+//----------------------------------------------------------------------
+// SaveSnapshot
+//      Write the state of the machine, and the address space of the
+//      current thread, to a host file.  Meant to be called once the
+//      program is loaded and its registers are initialized, before it
+//      runs its first instruction.
+//
+//      "name" -- the host file to create
+//----------------------------------------------------------------------
+
+void SaveSnapshot(const char *name) {
+#ifdef DEMAND_PAGING
+    // the program is not in memory yet, but in its executable, which
+    // the snapshot does not hold
+    printf("Snapshots are not supported with demand paging\n");
+    return;
+#endif
+    AddrSpace *space = currentThread->space;
+    SnapshotHeader *header = new SnapshotHeader;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int fd, i;
+
+    bzero((char *)header, sizeof(SnapshotHeader));
+    header->magic = SnapshotMagic;
+    header->memorySize = MemorySize;
+    header->numPages = space->GetNumPages();
+    header->processID = space->processID;
+    header->numPending = interrupt->SavePending(
+        header->pendingTypes, header->pendingWhens, MaxSnapshotInterrupts);
+
+    header->totalTicks = stats->totalTicks;
+    header->idleTicks = stats->idleTicks;
+    header->systemTicks = stats->systemTicks;
+    header->userTicks = stats->userTicks;
+
+    for (i = 0; i < NumTotalRegs; i++)
+        header->registers[i] = machine->ReadRegister(i);
+    for (i = 0; i < TEMP_MAXPROC_NUMBER; i++)
+        header->processTable[i] = processTable[i];
+    header->numProcess = numProcess;
+    for (i = 0; i < NumPhysPages; i++)
+        header->frameUsed[i] = frameProvider->IsFrameUsed(i);
+
+    DEBUG('a', "Saving snapshot to %s, %d pages, time %lld\n", name,
+          header->numPages, header->totalTicks);
+    fd = OpenForWrite(name);
+    WriteFile(fd, (char *)header, sizeof(SnapshotHeader));
+    WriteFile(fd, (char *)space->GetPageTable(),
+              header->numPages * sizeof(TranslationEntry));
+    WriteFile(fd, machine->mainMemory, MemorySize);
+    Close(fd);
+
+    delete header;
+    (void)interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// RestoreSnapshot
+//      Read a snapshot written by SaveSnapshot, and run the user program
+//      it holds in the current thread.
+//
+//      The frames the snapshot uses are claimed from the FrameProvider,
+//      so this has to be done before any other user program is loaded;
+//      only the frames reserved at boot are in use in both runs.
+//      Returns only if the snapshot cannot be used.
+//
+//      "name" -- the host file to read
+//----------------------------------------------------------------------
+
+void RestoreSnapshot(const char *name) {
+    SnapshotHeader *header = new SnapshotHeader;
+    TranslationEntry *table;
+    AddrSpace *space;
+    IntStatus oldLevel;
+    long long shift;
+    int fd, i;
+
+    fd = OpenForReadWrite(name, FALSE);
+    if (fd < 0) {
+        printf("Unable to open snapshot %s\n", name);
+        delete header;
+        return;
+    }
+    if ((ReadPartial(fd, (char *)header, sizeof(SnapshotHeader)) !=
+         sizeof(SnapshotHeader)) ||
+        (header->magic != SnapshotMagic) ||
+        (header->memorySize != MemorySize)) {
+        printf("%s is not a snapshot of this machine\n", name);
+        Close(fd);
+        delete header;
+        return;
+    }
+    for (i = NumReservedFrames; i < NumPhysPages; i++)
+        if (header->frameUsed[i] && !frameProvider->ClaimFrame(i)) {
+            printf("Frame %d of snapshot %s is in use\n", i, name);
+            while (--i >= NumReservedFrames) // give back those claimed
+                if (header->frameUsed[i])
+                    frameProvider->ReleaseFrame(i);
+            Close(fd);
+            delete header;
+            return;
+        }
+
+    DEBUG('a', "Restoring snapshot %s, %d pages, time %lld\n", name,
+          header->numPages, header->totalTicks);
+    table = new TranslationEntry[header->numPages];
+    Read(fd, (char *)table, header->numPages * sizeof(TranslationEntry));
+    Read(fd, machine->mainMemory, MemorySize);
+    Close(fd);
+    for (i = 0; i < NumPhysPages; i++)
+        machine->InvalidateDecodedFrame(i);
+
+    space = new AddrSpace(table, header->numPages);
+    currentThread->space = space;
+
+    // the address space took the first free process slot: put back the
+    // table, and the slot it had, as they were
+    for (i = 0; i < TEMP_MAXPROC_NUMBER; i++)
+        processTable[i] = header->processTable[i];
+    numProcess = header->numProcess;
+    space->processID = header->processID;
+
+    oldLevel = interrupt->SetLevel(IntOff); // keep the clock still
+    shift = header->totalTicks - stats->totalTicks;
+    stats->totalTicks = header->totalTicks;
+    stats->idleTicks = header->idleTicks;
+    stats->systemTicks = header->systemTicks;
+    stats->userTicks = header->userTicks;
+    interrupt->RestorePending(header->pendingTypes, header->pendingWhens,
+                              header->numPending, shift);
+    (void)interrupt->SetLevel(oldLevel);
+
+    for (i = 0; i < NumTotalRegs; i++)
+        machine->WriteRegister(i, header->registers[i]);
+    delete header;
+    space->RestoreState(); // load page table register
+
+    machine->Run(); // jump to the user progam
+    ASSERT(FALSE);  // machine->Run never returns
+}
@@ -0,0 +1,30 @@
+// snapshot.h
+//      Routines to save the state of the simulated machine, right after
+//      a user program was loaded, to a host file, and to start a later
+//      run of Nachos from that state instead of loading the program
+//      again.
+//
+//      A snapshot holds what the user program can see: main memory, the
+//      registers, the page table and the frames it uses, the process
+//      table, and the simulated clock along with the deadlines of the
+//      pending interrupts.  It does not hold kernel threads or interrupt
+//      handlers, which are host stacks and host addresses; the run that
+//      restores a snapshot has initialized its own kernel and devices
+//      the usual way, and only the user program is carried over.
+//
+//      A snapshot can only be restored by the same Nachos binary, with
+//      the same NumPhysPages, since the file holds host-format data.
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "copyright.h"
+
+extern void SaveSnapshot(const char *name); // Save the machine state and
+// the address space of the current thread
+// to the host file "name"
+extern void RestoreSnapshot(const char *name); // Give the current thread
+// the address space saved in "name", and
+// run it (does not return)
+
+#endif // SNAPSHOT_H
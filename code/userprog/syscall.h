@@ -54,9 +54,32 @@
 #define SC_WaitProcess 24
 #define SC_GetProcessID 25
 
+// Benchmarks
+#define SC_GetTicks 26
+
+// User-level synchronization
+#define SC_FutexWait 27
+#define SC_FutexWake 28
+#define SC_SemDestroy 29
+#define SC_RWLockCreate 30
+#define SC_RWLockAcquireRead 31
+#define SC_RWLockAcquireWrite 32
+#define SC_RWLockRelease 33
+#define SC_RWLockDestroy 34
+#define SC_BarrierCreate 35
+#define SC_BarrierWait 36
+#define SC_BarrierDestroy 37
+
 #ifdef IN_USER_MODE
 
-typedef int sem_t;
+typedef int sem_t; /* a handle on a kernel semaphore, -1 if none */
+typedef int rwlock_t; /* a handle on a reader-writer lock, -1 if none */
+typedef int barrier_t; /* a handle on a barrier, -1 if none */
+
+/* fairness policies of RWLockCreate (see RWLock in threads/synch.h) */
+#define RW_READER_PREFERENCE 0
+#define RW_WRITER_PREFERENCE 1
+#define RW_FIFO 2
 
 
 
@@ -76,14 +99,46 @@ typedef int sem_t;
 /* Stop Nachos, and print out performance stats */
 void Halt() __attribute__((noreturn));
 
-/*the creation of a user semaphore*/
-sem_t *SemInit(int val);
+/*the creation of a user semaphore; -1 if the process has too many*/
+sem_t SemInit(int val);
+
+/*the semP syscall; -1 if "sem" is not a semaphore of the process*/
+int SemP(sem_t sem);
+
+/*the semV syscall; -1 if "sem" is not a semaphore of the process*/
+int SemV(sem_t sem);
+
+/*free a semaphore; -1 if it is not one, or if threads are blocked on it*/
+int SemDestroy(sem_t sem);
+
+/*the creation of a reader-writer lock, with one of the RW_ policies;
+  -1 if the policy is unknown or if the process has too many*/
+rwlock_t RWLockCreate(int fairness);
+
+/*share the lock with the other readers; -1 if "lock" is not a lock*/
+int RWLockAcquireRead(rwlock_t lock);
+
+/*take the lock for writing; -1 if "lock" is not a lock, or if the
+  thread already holds it for writing*/
+int RWLockAcquireWrite(rwlock_t lock);
+
+/*release the lock, in the mode it was acquired; -1 if it is not held*/
+int RWLockRelease(rwlock_t lock);
+
+/*free a reader-writer lock; -1 if it is not one, or if it is held or
+  waited for*/
+int RWLockDestroy(rwlock_t lock);
+
+/*the creation of a barrier where "count" threads meet; -1 if count is
+  not positive or if the process has too many*/
+barrier_t BarrierCreate(int count);
 
-/*the semP syscall*/
-void SemP(sem_t *);
+/*wait for the other threads of the round; 1 in the last thread to
+  arrive, 0 in the others, -1 if "barrier" is not a barrier*/
+int BarrierWait(barrier_t barrier);
 
-/*the semV syscall*/
-void SemV(sem_t *);
+/*free a barrier; -1 if it is not one, or if threads wait at it*/
+int BarrierDestroy(barrier_t barrier);
 
 /*the join syscall*/
 void UserThreadJoin();
@@ -116,6 +171,14 @@ char GetInt(int *n);
  */
 int ForkExec(char *s) ;
 
+/* Duplicate the calling process: the child runs a copy of the calling
+ * thread, from the return of Fork, in a copy of the address space
+ * (shared copy-on-write).  Return the process ID of the child in the
+ * parent, 0 in the child, or -1 if the process could not be created.
+ * Not available with demand paging.
+ */
+int Fork(void);
+
 /* Waits for process pid to finish*/
 
 int WaitProcess(int processID);
@@ -124,6 +187,23 @@ int WaitProcess(int processID);
 
 int GetProcessID();
 
+/* Return the simulated time since Nachos started, in ticks (the low
+ * 32 bits of it); for measuring how long operations take.
+ */
+int GetTicks();
+
+/* Block until woken by FutexWake on "addr", unless the word at "addr"
+ * no longer holds "value".  Only meant to be called when a user-level
+ * lock is contended: see test/usync.h.  Returns 0 once woken, 1 if the
+ * word did not hold "value", -1 if "addr" is not a valid word.
+ */
+int FutexWait(int *addr, int value);
+
+/* Wake up to "count" threads blocked in FutexWait on "addr"; returns
+ * how many were woken.
+ */
+int FutexWake(int *addr, int count);
+
 /* Address space control operations: Exit, Exec, and Join */
 
 /* This user program is done (status = 0 means exited normally). */
@@ -185,14 +265,10 @@ int Read(char *buffer, int size, OpenFileId id);
 /* Close the file, we're done reading and writing to it. */
 void Close(OpenFileId id);
 
-/* User-level thread operations: Fork and Yield.  To allow multiple
- * threads to run within a user program.
- */
-
-/* Fork a thread to run a procedure ("func") in the *same* address space
- * as the current thread.
+/* User-level thread operations: Yield.  To allow multiple
+ * threads to run within a user program.  (Threads are created with
+ * ThreadCreate; Fork duplicates the process, see above.)
  */
-void Fork(void (*func)());
 
 /* Yield the CPU to another runnable thread, whether in this address space
  * or not.
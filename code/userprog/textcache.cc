@@ -0,0 +1,258 @@
+#include "system.h"
+#include "textcache.h"
+#include "synch.h"
+#include <stdio.h>
+
+
+//--------------------------------------------------------------------------
+// TextCache::TextCache
+//			Initialize an empty cache of the code of executables.
+//
+//			The cache holds, for each executable it knows, the frames of
+//			the pages that contain nothing but code: those are never
+//			written, so all the processes running the executable can map
+//			them read-only, instead of each reading the code from the
+//			file into frames of its own.  The cache keeps a reference
+//			on the frames (see FrameProvider::ShareFrame), so that the
+//			code stays in memory between two runs of the same program,
+//			until the frames are needed for something else (see Trim).
+//---------------------------------------------------------------------------
+
+TextCache::TextCache()
+{
+	for (int i = 0 ; i < TextCacheSize ; i ++)
+	{
+		entries[i].used = false ;
+		entries[i].frames = NULL ;
+	}
+	cacheLock = new Lock("TextCache lock") ;
+}
+
+//--------------------------------------------------------------------------
+// TextCache::~TextCache
+//			Clean up the resources used by the cache.
+//
+//			The frames are left as they are: the machine goes away with
+//			the cache.
+//---------------------------------------------------------------------------
+
+TextCache::~TextCache()
+{
+	for (int i = 0 ; i < TextCacheSize ; i ++)
+	{
+		delete[] entries[i].frames ;
+	}
+	delete cacheLock ;
+}
+
+//--------------------------------------------------------------------------
+// TextCache::Lookup
+//			Share the cached code frames of an executable.
+//
+//			The executable is found by the sector of its file header, and
+//			its code must be laid out as when it was loaded, lest the
+//			file was replaced meanwhile.  Each frame found gets one more
+//			user, the address space that maps it, which releases it
+//			like any other frame (see AddrSpace::FreeFrames).
+//
+//			args:
+//				key: the sector of the header of the executable
+//				code: the code segment of the executable
+//				frames: where to store the frames, by virtual page,
+//						from the first page holding nothing but code
+//				numFrames: the number of such pages
+//
+//			return:
+//				true if the code was cached, and its frames are stored,
+//				false otherwise
+//---------------------------------------------------------------------------
+
+bool TextCache::Lookup(int key, Segment *code, int *frames, int numFrames)
+{
+	bool found = false ;
+
+	cacheLock->Acquire() ;
+	for (int i = 0 ; i < TextCacheSize ; i ++)
+	{
+		TextEntry *entry = &entries[i] ;
+
+		if (entry->used && (entry->key == key) &&
+			(entry->code.virtualAddr == code->virtualAddr) &&
+			(entry->code.inFileAddr == code->inFileAddr) &&
+			(entry->code.size == code->size) &&
+			(entry->numFrames == numFrames))
+		{
+			for (int j = 0 ; j < numFrames ; j ++)
+			{
+				frameProvider->ShareFrame(entry->frames[j]) ;
+				frames[j] = entry->frames[j] ;
+			}
+			found = true ;
+			break ;
+		}
+	}
+	cacheLock->Release() ;
+
+	return found ;
+}
+
+//--------------------------------------------------------------------------
+// TextCache::Insert
+//			Keep the code frames of an executable that was just loaded,
+//			for the next processes running it.
+//
+//			The cache takes a reference of its own on each frame.  When
+//			the cache is full, the code no address space uses any more
+//			makes room; when everything is in use, the code is simply
+//			not kept.  An executable already cached, loaded meanwhile by
+//			another process, is kept as it was; one cached with another
+//			layout was replaced, and gives its place.
+//
+//			args:
+//				key: the sector of the header of the executable
+//				code: the code segment of the executable
+//				frames: the frames of the pages holding nothing but code
+//				numFrames: the number of such pages
+//---------------------------------------------------------------------------
+
+void TextCache::Insert(int key, Segment *code, int *frames, int numFrames)
+{
+	TextEntry *entry = NULL ;
+
+	if (numFrames <= 0) return ;
+
+	cacheLock->Acquire() ;
+	for (int i = 0 ; i < TextCacheSize ; i ++)
+	{
+		if (entries[i].used && (entries[i].key == key))
+		{
+			if ((entries[i].code.virtualAddr == code->virtualAddr) &&
+				(entries[i].code.inFileAddr == code->inFileAddr) &&
+				(entries[i].code.size == code->size) &&
+				(entries[i].numFrames == numFrames))
+			{
+				cacheLock->Release() ;
+				return ;
+			}
+			Drop(&entries[i]) ;
+		}
+		if (! entries[i].used && (entry == NULL))
+		{
+			entry = &entries[i] ;
+		}
+	}
+	for (int i = 0 ; (i < TextCacheSize) && (entry == NULL) ; i ++)
+	{
+		if (IsUnused(&entries[i]))
+		{
+			Drop(&entries[i]) ;
+			entry = &entries[i] ;
+		}
+	}
+
+	if (entry != NULL)
+	{
+		entry->used = true ;
+		entry->key = key ;
+		entry->code = *code ;
+		entry->numFrames = numFrames ;
+		entry->frames = new int[numFrames] ;
+		for (int j = 0 ; j < numFrames ; j ++)
+		{
+			frameProvider->ShareFrame(frames[j]) ;
+			entry->frames[j] = frames[j] ;
+		}
+		DEBUG('a', "Caching the code of executable %d, %d pages\n", key, numFrames) ;
+	}
+	cacheLock->Release() ;
+}
+
+//--------------------------------------------------------------------------
+// TextCache::Forget
+//			Drop the code of an executable, because its file is being
+//			written to.
+//
+//			The processes running the executable keep the frames they
+//			mapped; the next ones read the code from the file again.
+//
+//			arg:
+//				key: the sector of the header of the executable
+//---------------------------------------------------------------------------
+
+void TextCache::Forget(int key)
+{
+	cacheLock->Acquire() ;
+	for (int i = 0 ; i < TextCacheSize ; i ++)
+	{
+		if (entries[i].used && (entries[i].key == key))
+		{
+			Drop(&entries[i]) ;
+		}
+	}
+	cacheLock->Release() ;
+}
+
+//--------------------------------------------------------------------------
+// TextCache::Trim
+//			Drop the code of the executables no process is running, to
+//			give their frames back to the FrameProvider.
+//
+//			This is called when an address space is short of frames:
+//			the code kept for the next runs must not stand in the way of
+//			the programs running now.
+//---------------------------------------------------------------------------
+
+void TextCache::Trim()
+{
+	cacheLock->Acquire() ;
+	for (int i = 0 ; i < TextCacheSize ; i ++)
+	{
+		if (IsUnused(&entries[i]))
+		{
+			Drop(&entries[i]) ;
+		}
+	}
+	cacheLock->Release() ;
+}
+
+//--------------------------------------------------------------------------
+// TextCache::Drop
+//			Release the reference of the cache on the frames of an entry,
+//			and empty it.  The caller holds the 'cacheLock'.
+//
+//			arg:
+//				entry: the entry to empty, which must be used
+//---------------------------------------------------------------------------
+
+void TextCache::Drop(TextEntry *entry)
+{
+	DEBUG('a', "Dropping the code of executable %d\n", entry->key) ;
+	for (int j = 0 ; j < entry->numFrames ; j ++)
+	{
+		frameProvider->ReleaseFrame(entry->frames[j]) ;
+	}
+	delete[] entry->frames ;
+	entry->frames = NULL ;
+	entry->used = false ;
+}
+
+//--------------------------------------------------------------------------
+// TextCache::IsUnused
+//			Check whether the cache is the only user left of the frames
+//			of an entry.  The caller holds the 'cacheLock'.
+//
+//			The frames of an entry are always mapped together, so the
+//			first one tells for all of them.
+//
+//			arg:
+//				entry: the entry to check
+//
+//			return:
+//				true if the entry is used, and no address space maps its
+//				frames, false otherwise
+//---------------------------------------------------------------------------
+
+bool TextCache::IsUnused(TextEntry *entry)
+{
+	return entry->used && (frameProvider->GetRefCount(entry->frames[0]) == 1) ;
+}
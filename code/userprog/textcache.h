@@ -0,0 +1,51 @@
+#ifndef TEXTCACHE_H
+#define TEXTCACHE_H
+
+
+#include "noff.h"
+#include "synch.h"
+
+#define TextCacheSize 16						// executables whose code the cache can hold at once
+
+
+// The code of one executable, as loaded in memory
+
+class TextEntry
+{
+	public :
+
+		bool used ;							// whether this entry holds anything
+		int key ;							// sector of the header of the executable (see OpenFile::HeaderSector)
+		Segment code ;						// code segment of the executable, as it was loaded
+		int numFrames ;						// number of pages holding nothing but code
+		int *frames ;						// ... and the frames they are in, by virtual page
+} ;
+
+
+// The following class keeps the code of the executables that were run
+// in memory, so that the processes running the same one share its
+// frames rather than read it all over again
+
+class TextCache
+{
+	public :
+
+		TextCache() ;						// initializes an empty cache
+		~TextCache() ;						// cleans up resources used by the cache
+
+		bool Lookup(int key, Segment *code, int *frames, int numFrames) ;	// shares the cached code frames of an executable
+		void Insert(int key, Segment *code, int *frames, int numFrames) ;	// keeps the code frames of an executable just loaded
+		void Forget(int key) ;				// drops the code of an executable that may be changing
+		void Trim() ;						// drops the code no address space uses any more
+
+	private :
+
+		void Drop(TextEntry *entry) ;		// releases the frames of an entry, and empties it
+		bool IsUnused(TextEntry *entry) ;	// checks whether the cache is the last user of the frames of an entry
+
+		TextEntry entries[TextCacheSize] ;	// the executables whose code is kept
+		Lock *cacheLock ;					// lock to synchronise access to the entries
+} ;
+
+
+#endif
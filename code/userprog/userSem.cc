@@ -1,13 +1,52 @@
 #include "userSem.h"
+#include "system.h"
 
-Semaphore *SemInit(int val){
-    return new Semaphore("userSem", val);
+// Returns a handle on a new semaphore, or -1 if the process has too many
+int SemInit(int val){
+    Semaphore *sem = new Semaphore("userSem", val);
+    int handle = currentThread->space->handles->Add(SemaphoreHandle, sem);
+
+    if(handle < 0)
+        delete sem;
+    return handle;
 }
 
-void SemP(Semaphore *sem){
-    sem->P();
+// Interrupts stay off from the lookup of the handle until the thread
+// is done with the semaphore, or blocked on it: SemDestroy, which sees
+// only blocked threads, cannot delete the semaphore in between
+int SemP(int handle){
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    Semaphore *sem = (Semaphore *)currentThread->space->handles->Get(handle, SemaphoreHandle);
+
+    if(sem != NULL)
+        sem->P();
+    (void)interrupt->SetLevel(oldLevel);
+    return (sem == NULL) ? -1 : 0;
 }
 
-void SemV(Semaphore *sem){
-    sem->V();
-}
\ No newline at end of file
+int SemV(int handle){
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    Semaphore *sem = (Semaphore *)currentThread->space->handles->Get(handle, SemaphoreHandle);
+
+    if(sem != NULL)
+        sem->V();
+    (void)interrupt->SetLevel(oldLevel);
+    return (sem == NULL) ? -1 : 0;
+}
+
+// Fails, and keeps the semaphore, if threads are blocked on it: they
+// would never wake up
+int SemDestroy(int handle){
+    HandleTable *handles = currentThread->space->handles;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    Semaphore *sem = (Semaphore *)handles->Get(handle, SemaphoreHandle);
+
+    if(sem == NULL || sem->HasWaiters()){
+        (void)interrupt->SetLevel(oldLevel);
+        return -1;
+    }
+    handles->Remove(handle, SemaphoreHandle);
+    (void)interrupt->SetLevel(oldLevel);
+    delete sem;
+    return 0;
+}
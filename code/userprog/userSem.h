@@ -1,7 +1,13 @@
 #include "synch.h"
 
-Semaphore *SemInit(int val);
+// Semaphores of user programs, designated by handles in the handle
+// table of their process (see handletable.h).  All but SemInit return
+// -1 if the handle is not a live semaphore of the current process.
 
-void SemP(Semaphore *sem);
+int SemInit(int val);
 
-void SemV(Semaphore *sem);
\ No newline at end of file
+int SemP(int handle);
+
+int SemV(int handle);
+
+int SemDestroy(int handle);
@@ -0,0 +1,126 @@
+#include "userSynch.h"
+#include "system.h"
+
+// Returns a handle on a new lock, or -1 if "fairness" is not one of
+// the RWFairness policies or if the process has too many objects
+int RWLockCreate(int fairness){
+    if(fairness != ReaderPreference && fairness != WriterPreference &&
+       fairness != FifoFairness)
+        return -1;
+
+    RWLock *lock = new RWLock("userRWLock", (RWFairness)fairness);
+    int handle = currentThread->space->handles->Add(RWLockHandle, lock);
+
+    if(handle < 0)
+        delete lock;
+    return handle;
+}
+
+// As for semaphores (see userSem.cc), interrupts stay off from the
+// lookup of the handle until the thread holds the lock, waits for it,
+// or is done with it: the Destroy calls, which see only busy objects,
+// cannot delete it in between
+int RWLockAcquireRead(int handle){
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    RWLock *lock = (RWLock *)currentThread->space->handles->Get(handle, RWLockHandle);
+    int result = -1;
+
+    if(lock != NULL && !lock->isWriteHeldByCurrentThread()){
+        lock->AcquireRead();
+        result = 0;
+    }
+    (void)interrupt->SetLevel(oldLevel);
+    return result;
+}
+
+// Fails instead of deadlocking if the thread already holds the lock for
+// writing; a thread holding it for reading would deadlock, as the lock
+// does not know which threads are its readers
+int RWLockAcquireWrite(int handle){
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    RWLock *lock = (RWLock *)currentThread->space->handles->Get(handle, RWLockHandle);
+    int result = -1;
+
+    if(lock != NULL && !lock->isWriteHeldByCurrentThread()){
+        lock->AcquireWrite();
+        result = 0;
+    }
+    (void)interrupt->SetLevel(oldLevel);
+    return result;
+}
+
+// Releases the write lock if the thread holds it, a share of the lock
+// otherwise
+int RWLockRelease(int handle){
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    RWLock *lock = (RWLock *)currentThread->space->handles->Get(handle, RWLockHandle);
+    int result = 0;
+
+    if(lock == NULL)
+        result = -1;
+    else if(lock->isWriteHeldByCurrentThread())
+        lock->ReleaseWrite();
+    else if(lock->IsReadHeld())
+        lock->ReleaseRead();
+    else
+        result = -1;
+    (void)interrupt->SetLevel(oldLevel);
+    return result;
+}
+
+// Fails, and keeps the lock, if it is held or threads wait for it
+int RWLockDestroy(int handle){
+    HandleTable *handles = currentThread->space->handles;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    RWLock *lock = (RWLock *)handles->Get(handle, RWLockHandle);
+
+    if(lock == NULL || lock->IsBusy()){
+        (void)interrupt->SetLevel(oldLevel);
+        return -1;
+    }
+    handles->Remove(handle, RWLockHandle);
+    (void)interrupt->SetLevel(oldLevel);
+    delete lock;
+    return 0;
+}
+
+// Returns a handle on a new barrier, or -1 if "count" is not positive
+// or if the process has too many objects
+int BarrierCreate(int count){
+    if(count <= 0)
+        return -1;
+
+    Barrier *barrier = new Barrier("userBarrier", count);
+    int handle = currentThread->space->handles->Add(BarrierHandle, barrier);
+
+    if(handle < 0)
+        delete barrier;
+    return handle;
+}
+
+int BarrierWait(int handle){
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    Barrier *barrier = (Barrier *)currentThread->space->handles->Get(handle, BarrierHandle);
+    int result = -1;
+
+    if(barrier != NULL)
+        result = barrier->Wait() ? 1 : 0;
+    (void)interrupt->SetLevel(oldLevel);
+    return result;
+}
+
+// Fails, and keeps the barrier, if threads wait at it
+int BarrierDestroy(int handle){
+    HandleTable *handles = currentThread->space->handles;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    Barrier *barrier = (Barrier *)handles->Get(handle, BarrierHandle);
+
+    if(barrier == NULL || barrier->HasWaiters()){
+        (void)interrupt->SetLevel(oldLevel);
+        return -1;
+    }
+    handles->Remove(handle, BarrierHandle);
+    (void)interrupt->SetLevel(oldLevel);
+    delete barrier;
+    return 0;
+}
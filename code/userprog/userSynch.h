@@ -0,0 +1,22 @@
+#include "synch.h"
+
+// Reader-writer locks and barriers of user programs, designated by
+// handles in the handle table of their process (see handletable.h).
+// All but the Create functions return -1 if the handle is not a live
+// object of the right kind in the current process.
+
+int RWLockCreate(int fairness);
+
+int RWLockAcquireRead(int handle);
+
+int RWLockAcquireWrite(int handle);
+
+int RWLockRelease(int handle);
+
+int RWLockDestroy(int handle);
+
+int BarrierCreate(int count);
+
+int BarrierWait(int handle);
+
+int BarrierDestroy(int handle);
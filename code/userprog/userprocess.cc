@@ -79,6 +79,96 @@ int do_UserProcessCreate(char *filename, int arg, int returnFun)
 	return addrSpace->processID ;
 }
 
+#ifndef DEMAND_PAGING
+//-------------------------------------------------------------------------------
+// StartForkedProcess
+//			Resumes the copy of the thread that called fork, in the child
+//
+//			This function restores the registers the calling thread had when
+//			it made the system call, with 0 as the result of the call, moves
+//			past the syscall instruction, then runs the thread. Does not return
+//			to the calling context
+//
+//			Arguments:
+//				r: the saved registers of the calling thread, an array of
+//					NumTotalRegs integers, deleted here
+//-------------------------------------------------------------------------------
+
+static void StartForkedProcess(int r)
+{
+	int *registers = (int *) r ;
+
+	for (int i = 0 ; i < NumTotalRegs ; i ++)
+	{
+		machine->WriteRegister(i, registers[i]) ;
+	}
+	delete[] registers ;
+	currentThread->space->RestoreState() ;
+
+	machine->WriteRegister(2, 0) ; // Fork returns 0 in the child
+	machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg)) ;
+	machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg)) ;
+	machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg) + 4) ;
+
+	machine->Run() ;
+
+	ASSERT(FALSE) ;
+}
+#endif
+
+//--------------------------------------------------------------------------
+// do_UserProcessFork
+//			Creates a new user process, a copy of the calling one.
+//
+//			The child gets a copy of the address space of the parent, whose
+//			pages are shared copy-on-write instead of read from the executable
+//			(see AddrSpace::AddrSpace(AddrSpace *)), and a single thread: a
+//			copy of the calling thread, on the same stack. Threads, and the
+//			semaphores and other objects of the parent, are not inherited.
+//			The copy is the main thread of the child: when the caller is a
+//			user thread, the copy ends by exiting the thread, which then
+//			ends the process (see SC_ThreadExit in exception.cc).
+//
+//			With demand paging, the pager maps each frame to a single page,
+//			so frames cannot be shared and fork is not available.
+//
+//			Returns:
+//				The identifier of the child process, or -1 if the process
+//				creation fails
+//---------------------------------------------------------------------------
+
+int do_UserProcessFork()
+{
+#ifdef DEMAND_PAGING
+	fprintf(stderr, "Error in do_UserProcessFork: Fork is not supported with demand paging\n");
+	return -1 ;
+#else
+	AddrSpace *addrSpace = new AddrSpace(currentThread->space) ;
+
+	int sp = currentThread->GetStackPointer() ;
+	if (sp != 0) // a user thread: keep its stack slot in the child
+	{
+		addrSpace->ClaimStackPointer(sp) ;
+	}
+
+	AcquireProcessLock() ;
+	numProcess++;
+	ReleaseProcessLock() ;
+
+	int *registers = new int[NumTotalRegs] ;
+	for (int i = 0 ; i < NumTotalRegs ; i ++)
+	{
+		registers[i] = machine->ReadRegister(i) ;
+	}
+
+	Thread *thread = new Thread("forked process", 1, sp) ;
+	thread->space = addrSpace ;
+	thread->Fork(StartForkedProcess, (int) registers) ;
+
+	return addrSpace->processID ;
+#endif
+}
+
 //--------------------------------------------------------------------------
 // do_UserProcessExit
 //			Exit the current user process, suspend the processs if it has 
@@ -167,6 +257,8 @@ void waitForChildrenToExit(AddrSpace *space){
 
 void cleanUpOnExit(int ID, AddrSpace *space){
 
+	space->handles->DestroyAll() ; // semaphores... left by the process
+
 	processLocks[ID]->Acquire();
 	processTable[ID] = 0;
 	processConds[ID]->Broadcast(processLocks[ID]);
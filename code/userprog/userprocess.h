@@ -7,6 +7,7 @@ void waitForChildrenToExit(AddrSpace *space);
 void cleanUpOnExit(int ID, AddrSpace *space);
 
 int do_UserProcessCreate(char *filename, int arg, int returnFun);
+int do_UserProcessFork();
 void do_UserProcessHalt() ;
 void do_UserProcessExit() ;
 void do_WaitProcess(int processID);
@@ -0,0 +1,297 @@
+// pager.cc
+//      Routines to bring the pages of user programs into memory on
+//      demand, and to evict them to the swap file.  See pager.h.
+
+#include "copyright.h"
+#include "pager.h"
+#include "addrspace.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// Pager::Pager
+//      Initialize the pager: no frame holds a page yet, and the swap
+//      file is empty.
+//----------------------------------------------------------------------
+
+Pager::Pager() {
+    for (int i = 0; i < NumPhysPages; i++) {
+        owners[i].space = NULL;
+        owners[i].inTransit = FALSE;
+    }
+    hand = 0;
+    transitWaiters = new List;
+    swap = new SwapFile("SWAP", NumSwapPages);
+}
+
+//----------------------------------------------------------------------
+// Pager::~Pager
+//      De-allocate the pager, and remove the swap file.
+//----------------------------------------------------------------------
+
+Pager::~Pager() {
+    delete swap;
+    delete transitWaiters;
+}
+
+//----------------------------------------------------------------------
+// Pager::PageFault
+//      Bring a page of an address space into memory, after the machine
+//      failed to translate an address because the page was invalid.
+//      The page goes to a free frame if there is one, or replaces the
+//      page evicted by Evict.
+//
+//      Called with interrupts disabled.  Getting a frame, or reading
+//      the page, may sleep: the page is then looked at again, as
+//      another thread may have brought it in, or be doing so.
+//
+//      "space" -- the address space that faulted
+//      "virtAddr" -- the address that could not be translated
+//
+// Returns:
+//      TRUE if the page is now valid, so the access can be retried.
+//----------------------------------------------------------------------
+
+bool Pager::PageFault(AddrSpace *space, int virtAddr) {
+    unsigned int vpn = (unsigned)virtAddr / PageSize;
+    TranslationEntry *entry;
+    int frame, slot;
+
+    if ((space == NULL) || (vpn >= space->GetNumPages()))
+        return FALSE;
+    entry = &space->GetPageTable()[vpn];
+    frame = -1;
+    for (;;) {
+        if (entry->valid) { // brought in by an earlier fault
+            if (frame >= 0)
+                frameProvider->ReleaseFrame(frame);
+            return TRUE;
+        }
+        if (InTransit(space, vpn)) { // being read in, or written out
+            if (frame >= 0) {
+                frameProvider->ReleaseFrame(frame);
+                frame = -1;
+            }
+            WaitTransit();
+            continue;
+        }
+        if (frame >= 0)
+            break;
+        frame = frameProvider->GetEmptyFrame(); // may wait for its lock
+        if (frame < 0)
+            frame = Evict(); // may wait for the write back
+        if ((frame < 0) && InTransit(NULL, -1)) { // no page to evict yet
+            WaitTransit();
+            continue;
+        }
+        if (frame < 0)
+            return FALSE;
+    }
+
+    // the frame belongs to the page from now on, before the page is
+    // read (which may sleep): the clock leaves it alone, and other
+    // faults on the page wait
+    owners[frame].space = space;
+    owners[frame].virtualPage = vpn;
+    owners[frame].inTransit = TRUE;
+    slot = space->GetSwapSlot(vpn);
+    if (slot >= 0)
+        swap->ReadPage(slot, &machine->mainMemory[frame * PageSize]);
+    else
+        space->ReadPage(vpn, &machine->mainMemory[frame * PageSize]);
+    machine->InvalidateDecodedFrame(frame);
+    stats->numPageFaults++;
+    DEBUG('a', "Page fault at 0x%x: page %d in frame %d, from %s\n", virtAddr,
+          vpn, frame, (slot >= 0) ? "swap" : "executable");
+
+    entry->physicalPage = frame;
+    entry->valid = TRUE;
+    entry->use = FALSE;
+    entry->dirty = FALSE;
+    EndTransit(frame);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Pager::Evict
+//      Free a frame by evicting the page it holds, chosen by the clock:
+//      the hand skips, and clears the use bit of, the pages used since
+//      its last turn.  In its first turn, the hand also skips the unused
+//      pages that are dirty, remembering the first one, which is evicted
+//      if no clean page turns up; in its second turn, with the use bits
+//      all cleared, it takes the first page it meets.
+//
+// Returns:
+//      The frame, or -1 if no page can be evicted, or the swap file is
+//      full.
+//----------------------------------------------------------------------
+
+int Pager::Evict() {
+    int dirtyVictim = -1; // first unused dirty page met in the first turn
+    int victim = -1;
+
+#ifdef USE_TLB
+    tlbManager->Flush(); // for the latest use and dirty bits, and so
+                         // that the TLB does not map the victim
+#endif
+
+    for (int step = 0; step < 2 * NumPhysPages; step++) {
+        int frame = hand;
+        TranslationEntry *entry;
+
+        if ((step == NumPhysPages) && (dirtyVictim >= 0)) {
+            victim = dirtyVictim;
+            hand = (victim + 1) % NumPhysPages;
+            break;
+        }
+        hand = (hand + 1) % NumPhysPages;
+        if ((owners[frame].space == NULL) || owners[frame].inTransit)
+            continue;
+        entry = &owners[frame].space->GetPageTable()[owners[frame].virtualPage];
+        if (entry->use) { // second chance
+            entry->use = FALSE;
+            continue;
+        }
+        if (!entry->dirty || (step >= NumPhysPages)) {
+            victim = frame;
+            break;
+        }
+        if (dirtyVictim < 0)
+            dirtyVictim = frame;
+    }
+
+    // the translation caches hold pages whose use bit is set, and the
+    // victim: forget them, so that the machine sets the bits again
+    machine->FlushTranslationCache();
+    if ((victim < 0) || !EvictFrame(victim))
+        return -1;
+    stats->numEvictions++;
+    return victim;
+}
+
+//----------------------------------------------------------------------
+// Pager::EvictFrame
+//      Unmap the page held by a frame, writing it to the swap file first
+//      if it was modified since it was brought in.  A clean page needs no
+//      writing: it is the same as its copy in the swap file, or in the
+//      executable if it never went to swap.
+//
+//      The page is made invalid, and the frame put in transit, before
+//      the write, which may sleep: no other fault can pick the frame,
+//      nor read the page back before it is written.  The frame then
+//      has no owner, and belongs to the caller.
+//
+//      "frame" -- a frame holding a page
+//
+// Returns:
+//      FALSE if the page is dirty and the swap file is full.
+//----------------------------------------------------------------------
+
+bool Pager::EvictFrame(int frame) {
+    FrameOwner *owner = &owners[frame];
+    AddrSpace *space = owner->space;
+    int vpn = owner->virtualPage;
+    TranslationEntry *entry = &space->GetPageTable()[vpn];
+    int slot = space->GetSwapSlot(vpn);
+    bool dirty = entry->dirty;
+
+    if (dirty && (slot < 0)) {
+        slot = swap->AllocateSlot();
+        if (slot < 0) {
+            fprintf(stderr, "Pager: the swap file is full\n");
+            return FALSE;
+        }
+        space->SetSwapSlot(vpn, slot);
+    }
+    entry->valid = FALSE;
+    owner->inTransit = TRUE;
+    DEBUG('a', "Evicting page %d from frame %d%s\n", vpn, frame,
+          dirty ? ", written back to swap" : "");
+    if (dirty)
+        swap->WritePage(slot, &machine->mainMemory[frame * PageSize]);
+
+    owner->space = NULL;
+    EndTransit(frame);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Pager::InTransit
+//      Tell whether a page is being read into a frame, or written out of
+//      one.  Called with interrupts disabled.
+//
+//      "space" -- the address space of the page, or NULL for any one
+//      "vpn" -- the virtual page, or -1 for any page of "space"
+//----------------------------------------------------------------------
+
+bool Pager::InTransit(AddrSpace *space, int vpn) {
+    for (int i = 0; i < NumPhysPages; i++)
+        if (owners[i].inTransit &&
+            ((space == NULL) || (owners[i].space == space)) &&
+            ((vpn < 0) || (owners[i].virtualPage == vpn)))
+            return TRUE;
+    return FALSE;
+}
+
+//----------------------------------------------------------------------
+// Pager::WaitTransit
+//      Sleep until a transfer is over; the caller then checks again
+//      what it was waiting for.  Called with interrupts disabled.
+//----------------------------------------------------------------------
+
+void Pager::WaitTransit() {
+    transitWaiters->Append((void *)currentThread);
+    currentThread->Sleep();
+}
+
+//----------------------------------------------------------------------
+// Pager::EndTransit
+//      Take a frame out of transit, and wake up the threads waiting for
+//      a transfer to end.  Called with interrupts disabled.
+//
+//      "frame" -- the frame whose page was read or written
+//----------------------------------------------------------------------
+
+void Pager::EndTransit(int frame) {
+    Thread *thread;
+
+    owners[frame].inTransit = FALSE;
+    while ((thread = (Thread *)transitWaiters->Remove()) != NULL)
+        scheduler->ReadyToRun(thread);
+}
+
+//----------------------------------------------------------------------
+// Pager::ReleasePages
+//      Give back the frames and swap slots of an address space that is
+//      being destroyed.
+//
+//      Its pages are first taken out of the frame table, with interrupts
+//      disabled, so that a page fault in another address space cannot
+//      evict them while the frames are given back.  A page another
+//      fault is writing out is waited for, as its swap slot is in use.
+//----------------------------------------------------------------------
+
+void Pager::ReleasePages(AddrSpace *space) {
+    TranslationEntry *pageTable = space->GetPageTable();
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    unsigned int vpn;
+
+    while (InTransit(space, -1))
+        WaitTransit();
+    for (vpn = 0; vpn < space->GetNumPages(); vpn++) {
+        int slot = space->GetSwapSlot(vpn);
+
+        if (pageTable[vpn].valid)
+            owners[pageTable[vpn].physicalPage].space = NULL;
+        if (slot >= 0) {
+            swap->FreeSlot(slot);
+            space->SetSwapSlot(vpn, -1);
+        }
+    }
+    (void)interrupt->SetLevel(oldLevel);
+
+    for (vpn = 0; vpn < space->GetNumPages(); vpn++)
+        if (pageTable[vpn].valid) {
+            frameProvider->ReleaseFrame(pageTable[vpn].physicalPage);
+            pageTable[vpn].valid = FALSE;
+        }
+}
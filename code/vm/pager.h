@@ -0,0 +1,95 @@
+// pager.h
+//      Data structures for demand paging.
+//
+//      With demand paging, a user program is not loaded when its
+//      address space is created: all its pages start out invalid, and
+//      each one is brought into memory the first time it is touched,
+//      by the page fault handler.  A page comes from:
+//
+//              the swap file, if it was evicted before (see swapfile.h)
+//              the executable, if it holds code or initialized data
+//              nowhere otherwise -- it is filled with zeroes
+//
+//      When no frame is free, a resident page is evicted to make room,
+//      so a program can be larger than physical memory, and only the
+//      pages a program actually uses cost memory and time.
+//
+//      The pager keeps a global frame table: for each frame, the page it
+//      holds (an inverted page table), to find the page table entry of
+//      the page it evicts.  Frames it did not fill, such as the frames
+//      of an address space restored from a snapshot, are never evicted.
+//
+//      Victims are chosen by the clock algorithm (second chance): a hand
+//      sweeps the frame table, and a page whose use bit was set by the
+//      machine since the hand last passed gets its bit cleared and is
+//      spared, so the pages in use stay resident.  Among the pages not
+//      used, clean ones are taken before dirty ones, as only a dirty page
+//      has to be written back to the swap file: a clean page is still in
+//      its swap slot, or in the executable if it was never swapped out.
+//
+//      With a TLB (see tlbmanager.h), the use and dirty bits are in the TLB
+//      entries until they are copied back to the page table, so the
+//      TLB is flushed before a victim is chosen.
+//
+//      Paging happens inside the exception handler, with interrupts
+//      disabled, but reading or writing a page may put the thread to
+//      sleep (on a disk).  So before any of it, the frame is put "in
+//      transit", and the page is invalid: the frame keeps the owner of
+//      the page being written back, until the write is over, or already
+//      has the owner of the page being read in.  The clock skips the
+//      frames in transit, and a fault on a page in transit waits until
+//      the transfer is over, then looks at the page again.
+
+#ifndef PAGER_H
+#define PAGER_H
+
+#include "copyright.h"
+#include "list.h"
+#include "machine.h"
+#include "swapfile.h"
+
+class AddrSpace;
+
+// The page held by a frame.
+class FrameOwner {
+  public:
+    AddrSpace *space; // NULL if the frame is not paged
+    int virtualPage;
+    bool inTransit;   // the page is being read in or written out
+};
+
+// The following class defines the pager.  There is a single one,
+// "pager", used by the exception handler and by AddrSpace.
+
+class Pager {
+  public:
+    Pager();  // Initialize with every frame free, and an empty swap file
+    ~Pager(); // Remove the swap file
+
+    bool PageFault(AddrSpace *space, int virtAddr); // Bring the page of
+    // "virtAddr" into memory; FALSE if the address is not in "space",
+    // or memory and swap are both full
+
+    void ReleasePages(AddrSpace *space); // Free the frames and swap
+    // slots of "space", when it is destroyed
+
+  private:
+    int Evict(); // Make room: evict a page, return its frame
+    bool EvictFrame(int frame); // Write back the page of "frame" if
+    // it is dirty, and unmap it
+
+    bool InTransit(AddrSpace *space, int vpn); // Is page "vpn" of
+    // "space" (any of its pages, if "vpn" is -1; any page at all, if
+    // "space" is NULL) being transferred?
+    void WaitTransit(); // Sleep until a transfer is over
+    void EndTransit(int frame); // The transfer of "frame" is over:
+    // wake up the threads waiting for one
+
+    FrameOwner owners[NumPhysPages]; // the frame table: the page in
+    // each frame
+    int hand; // frame where the clock resumes its sweep
+    List *transitWaiters; // threads waiting for a transfer to end
+    SwapFile *swap; // where evicted pages go
+};
+
+#endif // PAGER_H
@@ -0,0 +1,79 @@
+// swapfile.cc
+//      Routines to keep evicted pages in a host file.  See swapfile.h.
+
+#include "copyright.h"
+#include "swapfile.h"
+#include "machine.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// SwapFile::SwapFile
+//      Create an empty swap file.  Any previous file of the same name is
+//      truncated: pages do not survive Nachos.
+//
+//      "name" -- the host file to use
+//      "numSlots" -- the largest number of pages the file can hold
+//----------------------------------------------------------------------
+
+SwapFile::SwapFile(const char *name, int numSlots) {
+    fileName = name;
+    file = OpenForWrite(name);
+    slots = new BitMap(numSlots);
+}
+
+//----------------------------------------------------------------------
+// SwapFile::~SwapFile
+//      Close the swap file, and remove it from the host.
+//----------------------------------------------------------------------
+
+SwapFile::~SwapFile() {
+    Close(file);
+    Unlink(fileName);
+    delete slots;
+}
+
+//----------------------------------------------------------------------
+// SwapFile::AllocateSlot
+//      Find a free slot for a page.
+//
+//      Returns the slot number, or -1 if the swap file is full.
+//----------------------------------------------------------------------
+
+int SwapFile::AllocateSlot() { return slots->Find(); }
+
+//----------------------------------------------------------------------
+// SwapFile::FreeSlot
+//      Give back a slot, whose contents are no longer needed.
+//----------------------------------------------------------------------
+
+void SwapFile::FreeSlot(int slot) { slots->Clear(slot); }
+
+//----------------------------------------------------------------------
+// SwapFile::ReadPage
+//      Read back the page saved in a slot.
+//
+//      "slot" -- an allocated slot, written to by WritePage
+//      "into" -- where to put the page (PageSize bytes)
+//----------------------------------------------------------------------
+
+void SwapFile::ReadPage(int slot, char *into) {
+    ASSERT(slots->Test(slot));
+    Lseek(file, slot * PageSize, 0);
+    Read(file, into, PageSize);
+    stats->numSwapReads++;
+}
+
+//----------------------------------------------------------------------
+// SwapFile::WritePage
+//      Save a page in a slot.
+//
+//      "slot" -- an allocated slot
+//      "from" -- the page to save (PageSize bytes)
+//----------------------------------------------------------------------
+
+void SwapFile::WritePage(int slot, const char *from) {
+    ASSERT(slots->Test(slot));
+    Lseek(file, slot * PageSize, 0);
+    WriteFile(file, from, PageSize);
+    stats->numSwapWrites++;
+}
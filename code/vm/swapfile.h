@@ -0,0 +1,40 @@
+// swapfile.h
+//      Data structures for the backing store of virtual memory.
+//
+//      Pages of user programs that are evicted from main memory are
+//      written to a swap file, a host file divided into slots of one
+//      page each.  A page keeps its slot until its address space is
+//      destroyed, so that evicting it again reuses the same slot.
+//
+//      The swap file is accessed synchronously, like the simulated
+//      disk contents, and does not advance the simulated clock.
+
+#ifndef SWAPFILE_H
+#define SWAPFILE_H
+
+#include "copyright.h"
+#include "bitmap.h"
+
+#define NumSwapPages 1024 // slots in the swap file
+
+// The following class defines the swap file.
+
+class SwapFile {
+  public:
+    SwapFile(const char *name, int numSlots); // Create an empty swap
+    // file, "numSlots" pages long
+    ~SwapFile(); // Close and remove the file
+
+    int AllocateSlot();    // A free slot, or -1 if the file is full
+    void FreeSlot(int slot); // Give back a slot
+
+    void ReadPage(int slot, char *into);       // Read a page from a slot
+    void WritePage(int slot, const char *from); // Write a page to a slot
+
+  private:
+    const char *fileName; // host file, removed when done
+    int file;             // its UNIX file descriptor
+    BitMap *slots;        // which slots hold a page
+};
+
+#endif // SWAPFILE_H
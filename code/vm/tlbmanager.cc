@@ -0,0 +1,144 @@
+// tlbmanager.cc
+//      Routines to refill and flush the software-loaded TLB.  See
+//      tlbmanager.h.
+
+#include "copyright.h"
+#include "tlbmanager.h"
+#include "addrspace.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// TLBManager::TLBManager
+//      Initialize the kernel side of the TLB; the machine starts with
+//      every entry invalid.
+//
+//      "replacement" -- how to choose the entry to replace on a miss
+//----------------------------------------------------------------------
+
+TLBManager::TLBManager(TLBPolicy replacement) {
+    policy = replacement;
+    loaded = NULL;
+    nextEntry = 0;
+}
+
+//----------------------------------------------------------------------
+// TLBManager::Refill
+//      Load the translation of an address into the TLB, after the
+//      machine failed to find it there.  This is the fast path of the
+//      exception handler: no page to bring in, just an entry to copy
+//      from the page table.
+//
+//      Called with interrupts disabled.
+//
+//      "space" -- the address space that missed; the TLB holds its
+//              translations
+//      "virtAddr" -- the address that could not be translated
+//
+// Returns:
+//      FALSE if the address is not in "space", or its page is not in
+//      memory.
+//----------------------------------------------------------------------
+
+bool TLBManager::Refill(AddrSpace *space, int virtAddr) {
+    unsigned int vpn = (unsigned)virtAddr / PageSize;
+    TranslationEntry *entry;
+    int i;
+
+    if ((space == NULL) || (vpn >= space->GetNumPages()))
+        return FALSE;
+    entry = &space->GetPageTable()[vpn];
+    if (!entry->valid)
+        return FALSE;
+    ASSERT(loaded == space);
+
+    i = ChooseEntry();
+    if (machine->tlb[i].valid) {
+        WriteBack(i);
+        machine->FlushTranslationCache(); // the entry may be cached
+    }
+    machine->tlb[i] = *entry;
+    machine->tlb[i].virtualPage = vpn;
+    machine->tlb[i].use = FALSE; // collected again from now on
+    machine->tlb[i].dirty = FALSE;
+    DEBUG('a', "TLB refill: page %d in frame %d, entry %d\n", vpn,
+          entry->physicalPage, i);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// TLBManager::ChooseEntry
+//      Choose the entry to refill: a free one if there is any, or the
+//      victim of the replacement policy.
+//----------------------------------------------------------------------
+
+int TLBManager::ChooseEntry() {
+    int i, victim;
+
+    if (policy == TLBFifo) { // the TLB fills in order after a flush
+        victim = nextEntry;
+        nextEntry = (nextEntry + 1) % machine->tlbSize;
+        return victim;
+    }
+    for (i = 0; i < machine->tlbSize; i++)
+        if (!machine->tlb[i].valid)
+            return i;
+    if (policy == TLBRandom)
+        return Random() % machine->tlbSize;
+    victim = 0; // TLBLru
+    for (i = 1; i < machine->tlbSize; i++)
+        if (machine->tlbLastUse[i] < machine->tlbLastUse[victim])
+            victim = i;
+    return victim;
+}
+
+//----------------------------------------------------------------------
+// TLBManager::WriteBack
+//      Copy the use and dirty bits the machine set in a TLB entry back
+//      to the page table of the address space loaded.
+//----------------------------------------------------------------------
+
+void TLBManager::WriteBack(int entry) {
+    TranslationEntry *tlbEntry = &machine->tlb[entry];
+    TranslationEntry *pageEntry =
+        &loaded->GetPageTable()[tlbEntry->virtualPage];
+
+    if (tlbEntry->use)
+        pageEntry->use = TRUE;
+    if (tlbEntry->dirty)
+        pageEntry->dirty = TRUE;
+}
+
+//----------------------------------------------------------------------
+// TLBManager::Load
+//      Make the TLB hold the translations of an address space.  If it
+//      held those of another one, they are flushed; if it held those of
+//      this one, nothing is done.
+//
+//      "space" -- the address space about to run, or NULL to flush the
+//              TLB for good (when the address space loaded is destroyed)
+//----------------------------------------------------------------------
+
+void TLBManager::Load(AddrSpace *space) {
+    if (space == loaded)
+        return;
+    if (loaded != NULL)
+        Flush();
+    loaded = space;
+}
+
+//----------------------------------------------------------------------
+// TLBManager::Flush
+//      Invalidate every entry of the TLB, after copying its use and
+//      dirty bits back to the page table.
+//----------------------------------------------------------------------
+
+void TLBManager::Flush() {
+    for (int i = 0; i < machine->tlbSize; i++)
+        if (machine->tlb[i].valid) {
+            WriteBack(i);
+            machine->tlb[i].valid = FALSE;
+        }
+    nextEntry = 0;
+    machine->FlushTranslationCache();
+    stats->numTLBFlushes++;
+}
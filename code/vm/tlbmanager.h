@@ -0,0 +1,72 @@
+// tlbmanager.h
+//      Data structures for managing the software-loaded TLB.
+//
+//      With USE_TLB, the machine translates addresses through a small
+//      TLB (see machine.h) instead of the page table of the running
+//      address space.  A translation missing from the TLB raises a
+//      PageFaultException, and the exception handler refills the TLB
+//      from the page table -- after bringing the page into memory, if
+//      it is not there yet (see pager.h) -- and retries the access, as
+//      the kernel of a real MIPS does.
+//
+//      The TLB has "-tlb" entries.  When they are all in use, the one
+//      to replace is chosen by the policy given with "-tlbp":
+//
+//              random  any entry (the default, as on the MIPS R3000)
+//              fifo    the entry loaded the longest ago
+//              lru     the entry used the longest ago
+//
+//      The machine sets the use and dirty bits of the TLB entries, not
+//      of the page table: they are copied back to the page table when
+//      an entry is replaced, or when the TLB is flushed, so that the
+//      pager sees them.
+//
+//      The TLB only holds translations of one address space.  It is
+//      flushed when a thread of another one gets the CPU, but not on a
+//      switch between threads of the same address space, nor to and
+//      from kernel threads.  The pager flushes it before it evicts a
+//      page, to see the latest use and dirty bits.
+//
+//      Requires DEMAND_PAGING: the page tables are never loaded into
+//      the machine, so address spaces cannot be loaded eagerly.
+
+#ifndef TLBMANAGER_H
+#define TLBMANAGER_H
+
+#include "copyright.h"
+#include "machine.h"
+
+class AddrSpace;
+
+// The replacement policies of the TLB.
+enum TLBPolicy { TLBRandom, TLBFifo, TLBLru };
+
+// The following class defines the kernel side of the TLB.  There is a
+// single one, "tlbManager", used by the exception handler, AddrSpace and
+// the pager.
+
+class TLBManager {
+  public:
+    TLBManager(TLBPolicy replacement); // Initialize, with the TLB empty
+
+    bool Refill(AddrSpace *space, int virtAddr); // Load the translation
+    // of "virtAddr" into the TLB, after a miss; FALSE if its page is
+    // not in memory
+
+    void Load(AddrSpace *space); // Make the TLB hold the translations
+    // of "space" (NULL: of none), flushing those of another one
+    bool IsLoaded(AddrSpace *space) { return space == loaded; }
+
+    void Flush(); // Empty the TLB, copying the use and dirty bits back
+    // to the page table
+
+  private:
+    int ChooseEntry();         // The entry to refill
+    void WriteBack(int entry); // Copy its use and dirty bits back
+
+    TLBPolicy policy;  // how ChooseEntry picks a victim
+    AddrSpace *loaded; // whose translations the TLB holds, if any
+    int nextEntry;     // with FIFO, the entry loaded the longest ago
+};
+
+#endif // TLBMANAGER_H